@@ -9,7 +9,15 @@
 
 #include <ncui_common.h>
 #include <ncui_types.h>
+#include <ncui_layout.h>
+#include <ncui_event.h>
+#include <ncui_timer.h>
+#include <ncui_input.h>
+#include <ncui_style.h>
+#include <ncui_validator.h>
+#include <ncui_keymap.h>
 #include <ncui_screen.h>
 #include <ncui_window.h>
+#include <ncui_async.h>
 
 #endif /* NCURSES_H */
@@ -0,0 +1,320 @@
+/**
+ * @file ncui_async.h
+ * @author notweerdmonk
+ * @brief Coroutines resumed by the event loop of ncui::Screen. Requires
+ * C++20, the declarations are omitted otherwise.
+ */
+
+#ifndef NCUI_ASYNC_H
+#define NCUI_ASYNC_H
+
+#include <ncui_common.h>
+#include <ncui_types.h>
+#include <ncui_event.h>
+#include <ncui_screen.h>
+#include <ncui_window.h>
+
+#if defined(__cpp_impl_coroutine) && (__cplusplus >= 202002L)
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+
+namespace ncui {
+
+  template <typename T>
+  class task;
+
+  namespace detail {
+
+    /**
+     * @brief The common part of the promises of all ncui::task types.
+     */
+    struct task_promise_base {
+      std::coroutine_handle<> continuation;
+      std::exception_ptr error;
+      bool detached = false;
+
+      /**
+       * @brief Resume the awaiting coroutine, or destroy the frame of a
+       * detached task.
+       */
+      struct final_awaiter {
+        bool await_ready() noexcept {
+          return false;
+        }
+
+        template <typename P>
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<P> h) noexcept {
+
+          task_promise_base& p = h.promise();
+          if (p.continuation) {
+            return p.continuation;
+          }
+          if (p.detached) {
+            h.destroy();
+          }
+          return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {
+        }
+      };
+
+      std::suspend_always initial_suspend() noexcept {
+        return {};
+      }
+
+      final_awaiter final_suspend() noexcept {
+        return {};
+      }
+
+      void unhandled_exception() {
+        /* Nobody can observe the exception of a detached task */
+        if (detached) {
+          std::terminate();
+        }
+        error = std::current_exception();
+      }
+    };
+
+    template <typename T>
+    struct task_promise : public task_promise_base {
+      std::optional<T> value;
+
+      task<T> get_return_object();
+
+      void return_value(T v) {
+        value.emplace(std::move(v));
+      }
+
+      T result() {
+        if (error) {
+          std::rethrow_exception(error);
+        }
+        return std::move(*value);
+      }
+    };
+
+    template <>
+    struct task_promise<void> : public task_promise_base {
+      task<void> get_return_object();
+
+      void return_void() {
+      }
+
+      void result() {
+        if (error) {
+          std::rethrow_exception(error);
+        }
+      }
+    };
+
+    /**
+     * @brief Resume a coroutine, as a callback of ncui::Screen.
+     * @param data The address of the coroutine.
+     */
+    inline void* resume_cb(void* data) {
+      std::coroutine_handle<>::from_address(data).resume();
+      return NULL;
+    }
+  }
+
+  /**
+   * @brief A coroutine that starts when it is awaited, or when it is passed
+   * to ncui::spawn.
+   */
+  template <typename T = void>
+  class task {
+  public:
+    typedef detail::task_promise<T> promise_type;
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+
+    template <typename U>
+    friend void spawn(task<U> t);
+
+  public:
+    explicit task(std::coroutine_handle<promise_type> h) : handle(h) {
+    }
+
+    task(task&& other) noexcept : handle(other.handle) {
+      other.handle = nullptr;
+    }
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task() {
+      if (handle) {
+        handle.destroy();
+      }
+    }
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+      handle.promise().continuation = awaiting;
+      return handle;
+    }
+
+    T await_resume() {
+      return handle.promise().result();
+    }
+  };
+
+  template <typename T>
+  inline task<T> detail::task_promise<T>::get_return_object() {
+    return task<T>(
+        std::coroutine_handle<task_promise<T> >::from_promise(*this));
+  }
+
+  inline task<void> detail::task_promise<void>::get_return_object() {
+    return task<void>(
+        std::coroutine_handle<task_promise<void> >::from_promise(*this));
+  }
+
+  /**
+   * @brief Start a task that nobody awaits. Its frame is freed when it
+   * finishes.
+   * @param t The task.
+   */
+  template <typename T>
+  void spawn(task<T> t) {
+    std::coroutine_handle<typename task<T>::promise_type> h = t.handle;
+    t.handle = nullptr;
+    h.promise().detached = true;
+    h.resume();
+  }
+
+  /**
+   * @brief Awaitable of the next key pressed in a window.
+   */
+  class next_key {
+    Window* win;
+    int ids[2];
+    int key;
+    std::coroutine_handle<> awaiting;
+
+    void on_key(const KeyEvent& ev) {
+      win->unsubscribe(ids[0]);
+      win->unsubscribe(ids[1]);
+      key = ev.key;
+      /* The dispatch is not over, the coroutine is resumed after it */
+      win->get_screen()->post(&detail::resume_cb, awaiting.address());
+    }
+
+  public:
+    /**
+     * @brief Constructor.
+     * @param _win The window, it receives the keys dispatched to it and to
+     * its descendants. It must outlive the wait.
+     */
+    explicit next_key(Window* _win) : win(_win), key(ERR) {
+    }
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+      awaiting = h;
+      key_handler_t handler = key_handler_t::bind(
+          [this](const KeyEvent& ev) { on_key(ev); }
+        );
+      ids[0] = win->on_key(handler);
+      ids[1] = win->on_term(handler);
+    }
+
+    /**
+     * @return The ncurses key code.
+     */
+    int await_resume() const noexcept {
+      return key;
+    }
+  };
+
+  /**
+   * @brief Awaitable of the expiry of a timer of the current screen.
+   */
+  class sleep_for {
+    unsigned long ms;
+
+  public:
+    /**
+     * @brief Constructor.
+     * @param _ms The delay in milliseconds.
+     */
+    explicit sleep_for(unsigned long _ms) : ms(_ms) {
+    }
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+      Screen::get_current().add_timer(ms, &detail::resume_cb, h.address());
+    }
+
+    void await_resume() const noexcept {
+    }
+  };
+
+  /**
+   * @brief Awaitable of a file descriptor becoming readable, watched by the
+   * current screen.
+   */
+  class readable {
+    Screen* scr;
+    int fd;
+    int events;
+    std::coroutine_handle<> awaiting;
+
+    static void* ready_cb(int _fd, int _events, fd_cb_data_t cb_data) {
+      readable& me = *(readable*)cb_data;
+      me.scr->unwatch_fd(_fd);
+      me.events = _events;
+      me.awaiting.resume();
+      return NULL;
+    }
+
+  public:
+    /**
+     * @brief Constructor.
+     * @param _fd The file descriptor, it must not be watched already.
+     */
+    explicit readable(int _fd) : scr(NULL), fd(_fd), events(0) {
+    }
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+      awaiting = h;
+      scr = &Screen::get_current();
+      if (!scr->watch_fd(fd, FD_EV_READ, &ready_cb, this)) {
+        events = FD_EV_ERROR;
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     * @return The ready events, a bitwise OR of FD_EV_READ, FD_EV_HUP and
+     * FD_EV_ERROR. Only FD_EV_ERROR if the descriptor can not be watched.
+     */
+    int await_resume() const noexcept {
+      return events;
+    }
+  };
+
+}
+
+#endif /* __cpp_impl_coroutine */
+
+#endif /* NCUI_ASYNC_H */
@@ -11,16 +11,32 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <memory>
 #include <functional>
 #include <algorithm>
+#include <new>
+#include <type_traits>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <stdexcept>
 
 #include <cstdio>
 #include <cstring>
+#include <cstdint>
+#include <cctype>
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <signal.h>
+#include <time.h>
+#include <errno.h>
 #include <assert.h>
 
 #include <pthread.h>
@@ -0,0 +1,212 @@
+/**
+ * @file ncui_event.h
+ * @author notweerdmonk
+ * @brief Typed events and delegates to handle them.
+ */
+
+#ifndef NCUI_EVENT_H
+#define NCUI_EVENT_H
+
+#include <ncui_common.h>
+
+namespace ncui {
+
+  class Window;
+
+  /**
+   * Phases of the dispatch of an event along the window hierarchy.
+   */
+  typedef enum {
+    EV_PHASE_CAPTURE, /**< From the root window down to the parent of target */
+    EV_PHASE_TARGET,  /**< At the target window */
+    EV_PHASE_BUBBLE   /**< From the parent of target up to the root window */
+  } ev_phase_t;
+
+  /**
+   * @brief The common part of all events.
+   */
+  struct Event {
+    Window* target;   /**< The window where the event occurred */
+    Window* window;   /**< The window whose handlers are being called */
+    ev_phase_t phase; /**< The phase of the dispatch */
+    mutable bool stopped;
+
+    Event(Window* _target) :
+      target(_target), window(_target), phase(EV_PHASE_TARGET),
+      stopped(false) {
+    }
+
+    /**
+     * @brief Stop the dispatch of the event to further windows once the
+     * handlers of the current window have been called.
+     */
+    void stop_propagation() const {
+      stopped = true;
+    }
+  };
+
+  /**
+   * @brief A key was pressed in a window.
+   */
+  struct KeyEvent : public Event {
+    int key;          /**< The ncurses key code */
+
+    KeyEvent(Window* _target, int _key) : Event(_target), key(_key) {
+    }
+  };
+
+  /**
+   * @brief A mouse event occurred.
+   */
+  struct MouseEvent : public Event {
+    short id;         /**< The id of the mouse device */
+    int y;            /**< The screen-relative ordinate */
+    int x;            /**< The screen-relative abscissa */
+    mmask_t bstate;   /**< The button state bits */
+
+    MouseEvent(Window* _target, const MEVENT& ev) :
+      Event(_target), id(ev.id), y(ev.y), x(ev.x), bstate(ev.bstate) {
+    }
+  };
+
+  /**
+   * @brief The geometry of a window was changed by the layout.
+   */
+  struct ResizeEvent : public Event {
+    int h;            /**< The height available for content */
+    int w;            /**< The width available for content */
+
+    ResizeEvent(Window* _target, int _h, int _w) :
+      Event(_target), h(_h), w(_w) {
+    }
+  };
+
+  /**
+   * @brief A type erased callable with in-place storage, the common part of
+   * all ncui::delegate types.
+   */
+  class raw_delegate {
+  protected:
+    typedef void (*stub_t)(const void* storage, const void* ev);
+
+    enum {
+      STORAGE_SIZE = 3 * sizeof(void*)
+    };
+
+    stub_t stub;
+
+    union {
+      void* align;
+      unsigned char bytes[STORAGE_SIZE];
+    } storage;
+
+  public:
+    raw_delegate() : stub(NULL) {
+    }
+
+    /**
+     * @brief Check if the delegate is bound to a callable.
+     * @return true or false.
+     */
+    bool is_bound() const {
+      return stub != NULL;
+    }
+
+    /**
+     * @brief Call the bound callable with a type erased event.
+     * @param ev A pointer to the event.
+     */
+    void invoke(const void* ev) const {
+      stub(storage.bytes, ev);
+    }
+  };
+
+  /**
+   * @brief A handler for events of type Ev that never allocates.
+   * Functions and member functions bound as template arguments are called
+   * directly from the stub and can be inlined into it. Small function
+   * objects, such as lambdas capturing a few pointers, are stored in place.
+   */
+  template <typename Ev>
+  class delegate : public raw_delegate {
+
+    template <void (*F)(const Ev&)>
+    static void function_stub(const void* storage, const void* ev) {
+      (void)storage;
+      F(*static_cast<const Ev*>(ev));
+    }
+
+    template <typename T, void (T::*M)(const Ev&)>
+    static void method_stub(const void* storage, const void* ev) {
+      T* obj = *static_cast<T* const*>(storage);
+      (obj->*M)(*static_cast<const Ev*>(ev));
+    }
+
+    template <typename F>
+    static void functor_stub(const void* storage, const void* ev) {
+      (*static_cast<const F*>(storage))(*static_cast<const Ev*>(ev));
+    }
+
+  public:
+    /**
+     * @brief Bind a function.
+     * @return A delegate calling F.
+     */
+    template <void (*F)(const Ev&)>
+    static delegate bind() {
+      delegate d;
+      d.stub = &function_stub<F>;
+      return d;
+    }
+
+    /**
+     * @brief Bind a member function to an object.
+     * @param obj The object, it must outlive the delegate.
+     * @return A delegate calling obj->M.
+     */
+    template <typename T, void (T::*M)(const Ev&)>
+    static delegate bind(T* obj) {
+      delegate d;
+      *reinterpret_cast<T**>(d.storage.bytes) = obj;
+      d.stub = &method_stub<T, M>;
+      return d;
+    }
+
+    /**
+     * @brief Bind a function object. It is copied into the delegate, so it
+     * must be small, trivially copyable and aligned no more strictly than a
+     * pointer.
+     * @param f The function object.
+     * @return A delegate calling a copy of f.
+     */
+    template <typename F>
+    static delegate bind(const F& f) {
+      static_assert(sizeof(F) <= STORAGE_SIZE,
+          "delegate: function object too large for in-place storage");
+      static_assert(alignof(F) <= alignof(void*),
+          "delegate: function object too aligned for in-place storage");
+      static_assert(std::is_trivially_copyable<F>::value,
+          "delegate: function object must be trivially copyable");
+      delegate d;
+      new (d.storage.bytes) F(f);
+      d.stub = &functor_stub<F>;
+      return d;
+    }
+
+    /**
+     * @brief Call the bound callable.
+     * @param ev The event.
+     */
+    void operator()(const Ev& ev) const {
+      invoke(&ev);
+    }
+  };
+
+  typedef delegate<KeyEvent> key_handler_t;
+
+  typedef delegate<MouseEvent> mouse_handler_t;
+
+  typedef delegate<ResizeEvent> resize_handler_t;
+}
+
+#endif /* NCUI_EVENT_H */
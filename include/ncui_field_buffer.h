@@ -81,10 +81,132 @@ namespace ncui {
       }
     }
 
+    /**
+     * @brief Get the length of the text, which is not NUL-terminated if it
+     * fills the line_buffer.
+     * @return The number of characters before the first NUL character.
+     */
+    int length() const {
+      const void* end = memchr(str, '\0', len);
+      return (end != NULL) ? (int)((const char*)end - str) : len;
+    }
+
   } line_buf_t;
 
+  /**
+   * @brief An edit of a field_buffer: characters of a row replaced, and the
+   * cursor before and after it. Consecutive characters typed or erased are
+   * coalesced into one edit, up to INLINE of them.
+   */
+  typedef struct text_edit {
+
+    enum {
+      INLINE = 9      /**< Characters kept inline, the edit fills 32 bytes */
+    };
+
+    enum {
+      TYPE,           /**< Characters typed */
+      ERASE,          /**< Characters erased by backspaces */
+      MOVE            /**< The cursor moved to another row */
+    };
+
+    uint16_t row;     /**< Row of the characters */
+    uint16_t col;     /**< Column of the first character */
+    uint16_t brow;    /**< Cursor before the edit */
+    uint16_t bcol;
+    uint16_t arow;    /**< Cursor after the edit */
+    uint16_t acol;
+    uint8_t op;
+    uint8_t len;      /**< Number of characters */
+    char text[INLINE];  /**< Characters after the edit */
+    char old[INLINE];   /**< Characters before the edit */
+  } text_edit_t;
+
+  /**
+   * @brief A bounded ring of edits that can be undone and redone. Once full
+   * the oldest edit is dropped.
+   */
+  typedef struct edit_journal {
+
+    std::vector<text_edit_t> ring;
+    int first;      /**< Oldest edit */
+    int undo_n;     /**< Edits that can be undone, from the oldest */
+    int redo_n;     /**< Edits that can be redone, after them */
+    bool sealed;    /**< Whether the last edit can not be extended */
+
+    /**
+     * @brief Constructor.
+     * @param cap The maximum number of edits.
+     */
+    edit_journal(int cap) : ring(cap), first(0), undo_n(0), redo_n(0),
+      sealed(false) {
+    }
+
+    /**
+     * @brief Get the last edit, to extend it.
+     * @return The edit, NULL if there is none or it is sealed.
+     */
+    text_edit_t* last() {
+      if (sealed || (undo_n == 0)) {
+        return NULL;
+      }
+      return &ring[(first + undo_n - 1) % ring.size()];
+    }
+
+    /**
+     * @brief Add an edit, dropping those that can be redone and the oldest
+     * one if the ring is full.
+     * @return The edit, to be filled.
+     */
+    text_edit_t& push() {
+      redo_n = 0;
+      sealed = false;
+      if (undo_n == (int)ring.size()) {
+        first = (first + 1) % ring.size();
+        --undo_n;
+      }
+      return ring[(first + undo_n++) % ring.size()];
+    }
+
+    /**
+     * @brief Take the edit to undo.
+     * @return The edit, NULL if there is none.
+     */
+    const text_edit_t* undo() {
+      if (undo_n == 0) {
+        return NULL;
+      }
+      sealed = true;
+      ++redo_n;
+      return &ring[(first + --undo_n) % ring.size()];
+    }
+
+    /**
+     * @brief Take the edit to redo.
+     * @return The edit, NULL if there is none.
+     */
+    const text_edit_t* redo() {
+      if (redo_n == 0) {
+        return NULL;
+      }
+      sealed = true;
+      --redo_n;
+      return &ring[(first + undo_n++) % ring.size()];
+    }
+
+    /**
+     * @brief Forget all edits.
+     */
+    void clear() {
+      first = undo_n = redo_n = 0;
+      sealed = false;
+    }
+  } edit_journal_t;
+
   /**
    * @brief A struct to store and manipulate multiple line_buffer objects.
+   * Characters typed, backspaces and newlines are recorded in a journal to be
+   * undone and redone, if it is enabled.
    */
   typedef struct field_buffer {
 
@@ -93,14 +215,100 @@ namespace ncui {
     int idx;
     line_buf_t **rows;
 
+    int journal_cap;
+    edit_journal_t* journal;   /**< Allocated on the first edit */
+
+    /**
+     * @brief Record an edit after it is made, extending the last one if the
+     * character follows it.
+     * @param op The operation.
+     * @param row The row of the character.
+     * @param col The column of the character.
+     * @param n 1 if a character was replaced, 0 otherwise.
+     * @param old_c The character before the edit.
+     * @param new_c The character after the edit.
+     * @param brow The row of the cursor before the edit.
+     * @param bcol The column of the cursor before the edit.
+     */
+    void record(int op, int row, int col, int n, char old_c, char new_c,
+        int brow, int bcol) {
+
+      if (journal_cap <= 0) {
+        return;
+      }
+      if (journal == NULL) {
+        journal = new edit_journal_t(journal_cap);
+      }
+
+      text_edit_t* e = journal->last();
+      if ((e != NULL) && ((e->op != op) || (n != 1) ||
+            (e->len == text_edit_t::INLINE) || (e->row != row) ||
+            (e->arow != brow) || (e->acol != bcol))) {
+        e = NULL;
+      }
+
+      if ((e != NULL) && (op == text_edit_t::TYPE) &&
+          (col == e->col + e->len) &&
+          ((new_c != ' ') || (e->text[e->len - 1] == ' '))) {
+        /* Typing is coalesced up to the end of a word */
+        e->text[e->len] = new_c;
+        e->old[e->len] = old_c;
+        ++e->len;
+      } else if ((e != NULL) && (op == text_edit_t::ERASE) &&
+          (col == e->col - 1)) {
+        memmove(e->text + 1, e->text, e->len);
+        memmove(e->old + 1, e->old, e->len);
+        e->text[0] = new_c;
+        e->old[0] = old_c;
+        --e->col;
+        ++e->len;
+      } else {
+        e = &journal->push();
+        e->op = op;
+        e->row = row;
+        e->col = col;
+        e->len = n;
+        e->text[0] = new_c;
+        e->old[0] = old_c;
+        e->brow = brow;
+        e->bcol = bcol;
+      }
+
+      e->arow = idx;
+      e->acol = rows[idx]->idx;
+    }
+
+    /**
+     * @brief Put the characters of an edit back as they were before or
+     * after it, and the cursor.
+     * @param e The edit.
+     * @param after Whether to redo the edit instead of undoing it.
+     */
+    void apply(const text_edit_t& e, bool after) {
+      line_buf_t* line = rows[e.row];
+      memcpy(line->str + e.col, (after) ? e.text : e.old, e.len);
+      if (e.op != text_edit_t::MOVE) {
+        /* The end of the row is past the characters typed and before
+         * those erased */
+        bool past = (e.op == text_edit_t::TYPE) == after;
+        line->idx = e.col + ((past) ? e.len : 0);
+      }
+      idx = (after) ? e.arow : e.brow;
+      rows[idx]->idx = (after) ? e.acol : e.bcol;
+    }
+
     /**
      * @brief Constructor.
      * Create a new field_buffer object containing required number of
      * line_buffer objects, each of required size.
      * @param _rows Number of line_buffer objects.
      * @param _cols Size of each line_buffer.
+     * @param _journal_cap Maximum number of edits in the journal, 0 for no
+     * journal.
      */
-    field_buffer(int _rows, int _cols) : num_rows(_rows), num_cols(_cols), idx(0) {
+    field_buffer(int _rows, int _cols, int _journal_cap = 0) :
+      num_rows(_rows), num_cols(_cols), idx(0), journal_cap(_journal_cap),
+      journal(NULL) {
       rows = new line_buf_t*[num_rows];
       for (int i = 0; i < num_rows; i++) {
         rows[i] = new line_buf_t(num_cols);
@@ -116,6 +324,7 @@ namespace ncui {
         delete rows[i];
       }
       delete[] rows;
+      delete journal;
     }
 
     /**
@@ -185,37 +394,236 @@ namespace ncui {
      */
     bool put(char c) {
       if (idx < num_rows) {
+        int brow = idx;
+        int bcol = rows[idx]->idx;
+        int n = (bcol < rows[idx]->len) ? 1 : 0;
+        char old_c = (n == 1) ? rows[idx]->str[bcol] : '\0';
         if (rows[idx]->put(c) == false) {
-          newline();
+          advance();
         }
+        record((n == 1) ? text_edit_t::TYPE : text_edit_t::MOVE, brow, bcol, n,
+            old_c, c, brow, bcol);
       }
       return (idx < num_rows);
     }
 
     /**
-     * @brief Emulates a newline character.
-     * Decrements the cursor by one row.
+     * @brief Move the cursor to the next row, if any.
      */
-    void newline() {
+    void advance() {
       if (++idx == num_rows) {
         --idx;
       }
     }
 
+    /**
+     * @brief Emulates a newline character.
+     * Increments the cursor by one row.
+     */
+    void newline() {
+      int brow = idx;
+      int bcol = rows[idx]->idx;
+      advance();
+      record(text_edit_t::MOVE, brow, bcol, 0, '\0', '\0', brow, bcol);
+    }
+
+    /**
+     * @brief Copy as much of the content and the cursor of another
+     * field_buffer object as fits in this one. The journal is cleared.
+     * @param other The field_buffer object to copy from.
+     */
+    void copy_from(const field_buffer& other) {
+      for (int i = 0; i < num_rows; i++) {
+        line_buf_t* dst = rows[i];
+        memset(dst->str, 0, dst->len);
+        dst->idx = 0;
+        if (i < other.num_rows) {
+          const line_buf_t* src = other.rows[i];
+          memcpy(dst->str, src->str, std::min(dst->len, src->len));
+          dst->idx = std::min(src->idx, dst->len);
+        }
+      }
+      idx = std::min(other.idx, num_rows - 1);
+      if (journal != NULL) {
+        journal->clear();
+      }
+    }
+
+    /**
+     * @brief Replace the content with text, one line_buffer object per line.
+     * Lines longer than a line_buffer are cut and lines past the last row
+     * are dropped. The cursor is left at the end of the text and the
+     * journal is cleared.
+     * @param text The text, lines are separated by newline characters.
+     * @param len The length of the text.
+     */
+    void assign(const char* text, std::size_t len) {
+      const char* end = text + len;
+      for (int i = 0; i < num_rows; i++) {
+        line_buf_t* line = rows[i];
+        memset(line->str, 0, line->len);
+        line->idx = 0;
+        if (text < end) {
+          const char* eol = (const char*)memchr(text, '\n', end - text);
+          std::size_t n = ((eol != NULL) ? eol : end) - text;
+          line->idx = (int)std::min(n, (std::size_t)line->len);
+          memcpy(line->str, text, line->idx);
+          idx = i;
+          text = (eol != NULL) ? eol + 1 : end;
+        }
+      }
+      if (len == 0) {
+        idx = 0;
+      }
+      if (journal != NULL) {
+        journal->clear();
+      }
+    }
+
     /**
      * @brief Emulate a backspace character.
-     * Write a null character at the current position and decrement the cursor.
+     * Write a null character at the current position and decrement the
+     * cursor, moving to the previous row at the start of a row.
      */
     void bksp() {
-      if (idx > 0) {
-        if (idx < num_rows)
-          rows[idx]->bksp();
-        else
-          rows[--idx]->bksp();
+      int brow = idx;
+      int bcol = rows[idx]->idx;
+      if ((rows[idx]->idx == 0) && (idx > 0)) {
+        --idx;
+      }
+      int col = rows[idx]->idx - 1;
+      char old_c = (col >= 0) ? rows[idx]->str[col] : '\0';
+      rows[idx]->bksp();
+      record((col >= 0) ? text_edit_t::ERASE : text_edit_t::MOVE, idx,
+          std::max(col, 0), (col >= 0) ? 1 : 0, old_c, '\0', brow, bcol);
+    }
+
+    /**
+     * @brief Set the maximum number of edits in the journal, forgetting
+     * those in it.
+     * @param cap The maximum number of edits, 0 for no journal.
+     */
+    void set_journal_cap(int cap) {
+      delete journal;
+      journal = NULL;
+      journal_cap = cap;
+    }
+
+    /**
+     * @brief Undo the last edit in the journal.
+     * @return true if an edit was undone, false if there is none.
+     */
+    bool undo() {
+      const text_edit_t* e = (journal != NULL) ? journal->undo() : NULL;
+      if (e != NULL) {
+        apply(*e, false);
+      }
+      return (e != NULL);
+    }
+
+    /**
+     * @brief Redo the last edit undone.
+     * @return true if an edit was redone, false if there is none.
+     */
+    bool redo() {
+      const text_edit_t* e = (journal != NULL) ? journal->redo() : NULL;
+      if (e != NULL) {
+        apply(*e, true);
       }
+      return (e != NULL);
     }
   } field_buf_t;
 
+  /**
+   * @brief A view of a line of text, valid until the text is changed.
+   */
+  typedef struct line_view {
+    const char* str;  /**< The characters, not NUL-terminated */
+    int len;
+
+    /**
+     * @brief Copy the line.
+     * @return The line as a std::string.
+     */
+    std::string to_string() const {
+      return std::string(str, len);
+    }
+  } line_view_t;
+
+  /**
+   * @brief A view of the lines of a field_buffer object, without copying
+   * them. It is valid until the text of the textfield is changed, resized or
+   * destroyed.
+   */
+  class text_view {
+    const field_buf_t* buf;
+
+  public:
+    /**
+     * @brief An iterator over the lines of a view.
+     */
+    class const_iterator {
+      const field_buf_t* buf;
+      int row;
+
+    public:
+      const_iterator(const field_buf_t* _buf, int _row) :
+        buf(_buf), row(_row) {
+      }
+
+      line_view_t operator*() const {
+        line_view_t line = { buf->rows[row]->str, buf->rows[row]->length() };
+        return line;
+      }
+
+      const_iterator& operator++() {
+        ++row;
+        return *this;
+      }
+
+      bool operator==(const const_iterator& other) const {
+        return row == other.row;
+      }
+
+      bool operator!=(const const_iterator& other) const {
+        return row != other.row;
+      }
+    };
+
+    /**
+     * @brief Constructor.
+     * @param _buf The field_buffer object, NULL for an empty view.
+     */
+    text_view(const field_buf_t* _buf = NULL) : buf(_buf) {
+    }
+
+    /**
+     * @return The number of lines, the rows of the textfield.
+     */
+    int size() const {
+      return (buf != NULL) ? buf->num_rows : 0;
+    }
+
+    /**
+     * @brief Get a line.
+     * @param row Zero indexed row, less than size().
+     * @return A view of the line.
+     */
+    line_view_t operator[](int row) const {
+      return *const_iterator(buf, row);
+    }
+
+    const_iterator begin() const {
+      return const_iterator(buf, 0);
+    }
+
+    const_iterator end() const {
+      return const_iterator(buf, size());
+    }
+  };
+
+  typedef text_view text_view_t;
+
 }
 
 #endif /* NCUI_FIELD_BUFFER_H */
@@ -0,0 +1,252 @@
+/**
+ * @file ncui_input.h
+ * @author notweerdmonk
+ * @brief Sources of input events, and recording and replaying them.
+ */
+
+#ifndef NCUI_INPUT_H
+#define NCUI_INPUT_H
+
+#include <ncui_common.h>
+
+namespace ncui {
+
+  /**
+   * @brief A key or mouse event read by a screen.
+   */
+  typedef struct {
+    uint64_t time;  /**< Time the event was read, in ms */
+    int key;        /**< The ncurses key code, KEY_MOUSE for mouse events */
+    MEVENT mouse;   /**< The mouse event if key is KEY_MOUSE */
+  } input_event_t;
+
+  /**
+   * Modifiers of keys, added to the ncurses key code by the decoder of a
+   * screen. Keys with modifiers are past KEY_MAX.
+   */
+  typedef enum {
+    MOD_SHIFT = 0x10000,  /**< Shift */
+    MOD_ALT   = 0x20000,  /**< Alt or Meta, also an Escape before a key */
+    MOD_CTRL  = 0x40000,  /**< Control */
+    MOD_MASK  = 0x70000   /**< All modifiers */
+  } key_mod_t;
+
+  /**
+   * @param key A decoded key code.
+   * @return The ncurses key code without modifiers.
+   */
+  inline int key_code(int key) {
+    return (key > 0) ? (key & ~MOD_MASK) : key;
+  }
+
+  /**
+   * @param key A decoded key code.
+   * @return The modifiers of the key, a combination of key_mod_t.
+   */
+  inline int key_mods(int key) {
+    return (key > 0) ? (key & MOD_MASK) : 0;
+  }
+
+  /**
+   * Motion of the mouse reported by the terminal.
+   */
+  typedef enum {
+    MOUSE_MOTION_NONE,  /**< Buttons and the wheel only */
+    MOUSE_MOTION_DRAG,  /**< Motion while a button is held */
+    MOUSE_MOTION_ALL    /**< Any motion */
+  } mouse_motion_t;
+
+  /**
+   * @param ev A mouse event.
+   * @return true if the event only reports the position of the mouse, no
+   * button changed.
+   */
+  inline bool is_mouse_motion(const MEVENT& ev) {
+    return (ev.bstate & REPORT_MOUSE_POSITION) &&
+      !(ev.bstate & ~(REPORT_MOUSE_POSITION | BUTTON_SHIFT | BUTTON_ALT |
+            BUTTON_CTRL));
+  }
+
+  /**
+   * @brief Decodes keys read from a terminal by ncurses.
+   *
+   * ncurses matches the escape sequences of the keypad keys the terminal
+   * describes, waiting up to the escape delay for the rest of a sequence
+   * after an Escape. The decoder adds:
+   * - an Escape followed by a key without delay is the key with MOD_ALT
+   * - keys with modifiers of xterm, the extended capabilities such as kUP5,
+   *   are the key with MOD_SHIFT, MOD_ALT and MOD_CTRL
+   * - SGR (1006) mouse reports, which have no limit on the row and column,
+   *   are decoded if the terminal description has the older X10 reports.
+   *   A button released within the click interval of ncurses is reported as
+   *   a click
+   *
+   * A mouse report split across reads is kept until the rest of it arrives,
+   * or dropped after the escape delay.
+   */
+  class key_decoder {
+    /* Extended key codes of ncurses to decoded keys */
+    std::unordered_map<int, int> mod_keys;
+
+    /* An incomplete SGR mouse report, from the < after ESC [ */
+    std::string seq;
+    uint64_t deadline;
+
+    bool keys_loaded;
+    bool sgr_mouse;
+    mouse_motion_t motion;
+    mmask_t mouse_mask;
+    MEVENT press;
+    uint64_t press_time;
+
+    void load_keys();
+    int translate(int key);
+    bool mouse_report(bool release, input_event_t& ev, uint64_t now);
+
+  public:
+    key_decoder();
+
+    /**
+     * @brief Decode SGR mouse reports, asking the terminal for them, if the
+     * current terminal describes X10 reports. Mouse events are reported
+     * through ncurses otherwise. The terminal is asked to report motion.
+     * @param mask The mouse events reported.
+     * @param _motion The motion reported.
+     */
+    void enable_mouse(mmask_t mask, mouse_motion_t _motion);
+
+    /**
+     * @brief Stop the terminal sending SGR mouse reports and motion if it
+     * was asked to.
+     */
+    void disable_mouse();
+
+    /**
+     * @brief Read and decode the next key without blocking.
+     * @param win The window reading the key.
+     * @param[out] ev The event, its time is not set.
+     * @param now The current time in milliseconds.
+     * @return true if an event was read, false otherwise.
+     */
+    bool read(WINDOW* win, input_event_t& ev, uint64_t now);
+
+    /**
+     * @brief Get the time until an incomplete mouse report is dropped.
+     * @param now The current time in milliseconds.
+     * @return The time in milliseconds, -1 if there is none.
+     */
+    int next_timeout(uint64_t now);
+  };
+
+  typedef key_decoder key_decoder_t;
+
+  /**
+   * @brief A source of input events that replaces the terminal of a screen.
+   * Events are read by the focused textfield, one per iteration of the event
+   * loop.
+   */
+  class input_source {
+  public:
+    virtual ~input_source();
+
+    /**
+     * @brief Read the next event without blocking.
+     * @param[out] ev The event.
+     * @return true if an event was read, false if none is available yet.
+     */
+    virtual bool read(input_event_t& ev) = 0;
+
+    /**
+     * @brief Get the time until the next event is available.
+     * @param now The current time in milliseconds.
+     * @return The time in milliseconds, 0 if an event is available and -1 if
+     * no more events will be.
+     */
+    virtual int next_timeout(uint64_t now) = 0;
+  };
+
+  /**
+   * @brief Records input events with the time between them.
+   *
+   * A recording starts with the magic "NCUIKEY" and a version byte, followed
+   * by the events: the milliseconds since the previous event, the key code
+   * and for mouse events the row, column and button state, all as unsigned
+   * LEB128 varints.
+   */
+  class input_recorder {
+    FILE* fp;
+    uint64_t last;
+    bool started;
+    std::string buf;
+
+  public:
+    /**
+     * @brief Constructor. Writes the header of the recording.
+     * @param _fp The stream to write to, it is not closed.
+     */
+    explicit input_recorder(FILE* _fp);
+
+    ~input_recorder();
+
+    /**
+     * @brief Record an event.
+     * @param ev The event, its time must not be earlier than the time of
+     * the previous event.
+     */
+    void record(const input_event_t& ev);
+  };
+
+  typedef input_recorder input_recorder_t;
+
+  /**
+   * @brief Replays recorded input events, at their original pace or as fast
+   * as the event loop takes them.
+   */
+  class input_replayer : public input_source {
+    FILE* fp;
+    bool realtime;
+    bool valid;
+    bool done;
+    bool has_next;
+    bool started;
+    uint64_t start;
+    uint64_t offset;
+    unsigned long count;
+    input_event_t next;
+
+    bool fetch();
+
+  public:
+    /**
+     * @brief Constructor. Reads the header of the recording.
+     * @param _fp The stream to read from, it is not closed.
+     * @param _realtime Whether events are replayed with their recorded
+     * delays, measured from the first read.
+     */
+    input_replayer(FILE* _fp, bool _realtime);
+
+    /**
+     * @return true if the stream starts with a recording header.
+     */
+    bool is_valid() const;
+
+    /**
+     * @return true if all events have been read.
+     */
+    bool is_done() const;
+
+    /**
+     * @return The number of events read so far.
+     */
+    unsigned long get_count() const;
+
+    virtual bool read(input_event_t& ev);
+
+    virtual int next_timeout(uint64_t now);
+  };
+
+  typedef input_replayer input_replayer_t;
+
+}
+
+#endif /* NCUI_INPUT_H */
@@ -0,0 +1,194 @@
+/**
+ * @file ncui_keymap.h
+ * @author notweerdmonk
+ * @brief Bindings of keys and chords to actions, and their compiled lookup
+ * tables.
+ */
+
+#ifndef NCUI_KEYMAP_H
+#define NCUI_KEYMAP_H
+
+#include <ncui_common.h>
+#include <ncui_event.h>
+#include <ncui_input.h>
+
+namespace ncui {
+
+  /**
+   * Actions keys are bound to. Those editing the text or moving the cursor
+   * apply to textfields.
+   */
+  typedef enum {
+    ACTION_NONE,          /**< The key is dropped */
+    ACTION_INSERT,        /**< Put the character if printable ASCII,
+                               WIN_EV_TERM */
+    ACTION_NEWLINE,       /**< Move to the next row, WIN_EV_TERM */
+    ACTION_BACKSPACE,     /**< Erase the previous character, WIN_EV_TERM */
+    ACTION_SUBMIT,        /**< WIN_EV_TERM without editing the text */
+    ACTION_KEY,           /**< WIN_EV_KEY */
+    ACTION_FOCUS_NEXT,    /**< Focus the next textfield */
+    ACTION_FOCUS_PREV,    /**< Focus the previous textfield */
+    ACTION_CURSOR_LEFT,   /**< Move the cursor, WIN_EV_KEY */
+    ACTION_CURSOR_RIGHT,  /**< Move the cursor, WIN_EV_KEY */
+    ACTION_CURSOR_UP,     /**< Move the cursor, WIN_EV_KEY */
+    ACTION_CURSOR_DOWN,   /**< Move the cursor, WIN_EV_KEY */
+    ACTION_CURSOR_HOME,   /**< Move to the start of the row, WIN_EV_KEY */
+    ACTION_CURSOR_END,    /**< Move to the end of the row, WIN_EV_KEY */
+    ACTION_UNDO,          /**< Undo an edit, WIN_EV_TERM */
+    ACTION_REDO,          /**< Redo an edit, WIN_EV_TERM */
+    ACTION_CALL,          /**< Call the handler bound to the key */
+    ACTION_PREFIX,        /**< Wait for the next key of a chord */
+    ACTION_MAX            /**< Guard value */
+  } key_action_t;
+
+  /**
+   * @brief What a key does, looked up in a compiled table.
+   */
+  typedef struct {
+    uint16_t action;  /**< A key_action_t */
+    uint16_t arg;     /**< The handler of ACTION_CALL, the table of the next
+                        key of ACTION_PREFIX */
+  } key_slot_t;
+
+  /**
+   * @brief Bindings of keys and chords, sequences of keys, to actions and
+   * handlers.
+   *
+   * The bindings are compiled into tables of KEY_MAX + 1 slots, one for the
+   * first key and one for each prefix of a chord, so looking up a key is one
+   * index into an array. Keys past KEY_MAX are looked up in a hash map. A
+   * keymap with a base inherits its bindings, the table of a window starts
+   * from those of its screen, and is compiled again when either changes.
+   * The keymap of a screen starts from the default bindings:
+   * - printable characters insert, Enter is a newline
+   * - Backspace, DEL and Ctrl-H erase
+   * - Tab and Shift-Tab move the focus
+   * - Ctrl-_ undoes and Ctrl-R redoes
+   * - Escape, keys with modifiers and other keys of the keypad are
+   *   dispatched as WIN_EV_KEY
+   */
+  class keymap {
+
+    typedef struct {
+      std::vector<int> keys;
+      key_action_t action;
+      key_handler_t handler;
+    } binding_t;
+
+    std::vector<binding_t> bindings;
+
+    const keymap* base;
+
+    /* Compiled tables, KEY_MAX + 1 slots each, the first one for the
+     * first key */
+    std::vector<key_slot_t> tables;
+    std::vector<std::unordered_map<int, key_slot_t> > sparse;
+    std::vector<key_handler_t> handlers;
+    unsigned long version;
+    unsigned long base_version;
+    bool compiled;
+
+    static const key_slot_t none;
+    static const key_slot_t modified;
+
+    void compile();
+    void compile_from(const keymap* k);
+    int add_table();
+    key_slot_t& slot(int table, int key);
+    void apply(const binding_t& b);
+    void add(const std::vector<int>& keys, key_action_t action,
+        const key_handler_t& handler);
+
+  public:
+    /**
+     * @brief Constructor.
+     * @param _base The keymap to inherit bindings from, NULL for the default
+     * bindings. It must outlive this keymap.
+     */
+    keymap(const keymap* _base = NULL);
+
+    /**
+     * @brief Bind a key to an action, replacing its binding.
+     * @param key The ncurses key code.
+     * @param action The action.
+     */
+    void bind(int key, key_action_t action);
+
+    /**
+     * @brief Bind a key to a handler, called instead of dispatching an
+     * event.
+     * @param key The ncurses key code.
+     * @param handler The handler.
+     */
+    void bind(int key, const key_handler_t& handler);
+
+    /**
+     * @brief Bind a chord to an action. The keys before the last one wait
+     * for the next key, a key that continues no chord is dropped.
+     * @param keys The keys of the chord.
+     * @param action The action.
+     */
+    void bind(const std::vector<int>& keys, key_action_t action);
+
+    /**
+     * @brief Bind a chord to a handler.
+     * @param keys The keys of the chord.
+     * @param handler The handler.
+     */
+    void bind(const std::vector<int>& keys, const key_handler_t& handler);
+
+    /**
+     * @brief Drop the bindings of a key or chord made in this keymap, the
+     * inherited binding applies again.
+     * @param keys The keys of the chord, or a single key.
+     */
+    void unbind(const std::vector<int>& keys);
+
+    /**
+     * @brief Look up a key, compiling the tables if the bindings changed.
+     * @param table The table, 0 for the first key of a chord.
+     * @param key The ncurses key code.
+     * @return The slot of the key.
+     */
+    const key_slot_t& lookup(int table, int key) {
+      if (!compiled || ((base != NULL) && (base_version != base->stamp()))) {
+        compile();
+      }
+      if ((key >= 0) && (key <= KEY_MAX) &&
+          ((std::size_t)table < sparse.size())) {
+        return tables[((std::size_t)table * (KEY_MAX + 1)) + key];
+      }
+      return lookup_sparse(table, key);
+    }
+
+    /**
+     * @return A number changed by every change of the bindings of the
+     * keymap or of those it inherits.
+     */
+    unsigned long stamp() const {
+      return version + ((base != NULL) ? base->stamp() : 0);
+    }
+
+    /**
+     * @brief Look up a key past KEY_MAX.
+     * @param table The table.
+     * @param key The key.
+     * @return The slot of the key.
+     */
+    const key_slot_t& lookup_sparse(int table, int key) const;
+
+    /**
+     * @brief Call a handler bound to a key.
+     * @param arg The argument of the ACTION_CALL slot.
+     * @param ev The key event.
+     */
+    void call(uint16_t arg, const KeyEvent& ev) const {
+      handlers[arg](ev);
+    }
+  };
+
+  typedef keymap keymap_t;
+
+}
+
+#endif /* NCUI_KEYMAP_H */
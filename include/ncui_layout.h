@@ -0,0 +1,150 @@
+/**
+ * @file ncui_layout.h
+ * @author notweerdmonk
+ * @brief Size constraints and space distribution for the window layout.
+ */
+
+#ifndef NCUI_LAYOUT_H
+#define NCUI_LAYOUT_H
+
+namespace ncui {
+
+  /**
+   * Direction in which a container window arranges its children.
+   */
+  typedef enum {
+    LAYOUT_NONE,      /**< Children are placed at the origin of the parent */
+    LAYOUT_ROW,       /**< Children are placed side by side, left to right */
+    LAYOUT_COLUMN     /**< Children are stacked, top to bottom */
+  } layout_dir_t;
+
+  /**
+   * Unit of a size constraint.
+   */
+  typedef enum {
+    SIZE_FIXED,       /**< Number of character cells */
+    SIZE_PERCENT,     /**< Percentage of the space of the parent */
+    SIZE_FLEX         /**< Weighted share of the space left over */
+  } size_unit_t;
+
+  /**
+   * @brief A size constraint along one axis of a window.
+   */
+  typedef struct size_spec {
+
+    size_unit_t unit;
+    int value;
+    int min;
+    int max;
+
+    /**
+     * @brief Constructor.
+     * Create a constraint that takes all the space left over.
+     */
+    size_spec() : unit(SIZE_FLEX), value(1), min(0), max(0) {
+    }
+
+    /**
+     * @brief Constructor.
+     * @param _unit The unit of the constraint.
+     * @param _value The number of cells, the percentage or the flex weight.
+     * @param _min The minimum size in cells.
+     * @param _max The maximum size in cells, 0 for no limit.
+     */
+    size_spec(size_unit_t _unit, int _value, int _min = 0, int _max = 0) :
+      unit(_unit), value(_value), min(_min), max(_max) {
+    }
+
+    /**
+     * @brief Clamp a size in cells to the limits of the constraint.
+     * @param n The size in cells.
+     * @return The clamped size.
+     */
+    int clamp(int n) const {
+      if ((max > 0) && (n > max)) {
+        n = max;
+      }
+      if (n < min) {
+        n = min;
+      }
+      return (n < 0) ? 0 : n;
+    }
+
+    /**
+     * @brief Resolve the constraint against the available space. Flexible
+     * constraints take all of it.
+     * @param avail The available space in cells.
+     * @return The size in cells.
+     */
+    int resolve(int avail) const {
+      switch (unit) {
+        case SIZE_FIXED:
+          return clamp(value);
+        case SIZE_PERCENT:
+          return clamp((avail * value) / 100);
+        default:
+          return clamp(avail);
+      }
+    }
+
+    bool operator==(const size_spec& other) const {
+      return (unit == other.unit) && (value == other.value) &&
+        (min == other.min) && (max == other.max);
+    }
+
+    bool operator!=(const size_spec& other) const {
+      return !(*this == other);
+    }
+
+  } size_spec_t;
+
+  /**
+   * @brief Create a constraint of fixed number of cells.
+   * @param n The number of cells.
+   * @return A size_spec_t object.
+   */
+  inline size_spec_t size_fixed(int n) {
+    return size_spec_t(SIZE_FIXED, n);
+  }
+
+  /**
+   * @brief Create a constraint relative to the space of the parent.
+   * @param p The percentage.
+   * @param min The minimum size in cells.
+   * @param max The maximum size in cells, 0 for no limit.
+   * @return A size_spec_t object.
+   */
+  inline size_spec_t size_percent(int p, int min = 0, int max = 0) {
+    return size_spec_t(SIZE_PERCENT, p, min, max);
+  }
+
+  /**
+   * @brief Create a constraint sharing the space left over by fixed and
+   * percentage constraints among siblings.
+   * @param weight The weight of the share.
+   * @param min The minimum size in cells.
+   * @param max The maximum size in cells, 0 for no limit.
+   * @return A size_spec_t object.
+   */
+  inline size_spec_t size_flex(int weight = 1, int min = 0, int max = 0) {
+    return size_spec_t(SIZE_FLEX, weight, min, max);
+  }
+
+  /**
+   * @brief Distribute space along the main axis of a container among its
+   * children in one pass. Fixed and percentage constraints are resolved first,
+   * the rest is shared among flexible constraints by weight.
+   * @param specs The constraints of the children.
+   * @param n The number of children.
+   * @param avail The available space in cells.
+   * @param[out] sizes The size in cells of each child.
+   */
+  void layout_distribute(
+      const size_spec_t* specs,
+      int n,
+      int avail,
+      int* sizes
+    );
+}
+
+#endif /* NCUI_LAYOUT_H */
@@ -0,0 +1,95 @@
+/**
+ * @file ncui_output.h
+ * @author notweerdmonk
+ * @brief Buffered output to terminals.
+ */
+
+#ifndef NCUI_OUTPUT_H
+#define NCUI_OUTPUT_H
+
+#include <ncui_common.h>
+
+namespace ncui {
+
+  /**
+   * @brief A thread pumping the output of ncurses to terminals. ncurses
+   * writes to a pipe, which is drained into a buffer in memory and written to
+   * the terminal without blocking. A terminal that does not keep up only
+   * delays its own output, never ncurses or the other terminals.
+   */
+  class output_pump {
+
+    struct term_output;
+
+    typedef struct term_output term_output_t;
+
+    /**
+     * An end of the output registered in the epoll set.
+     */
+    typedef struct {
+      term_output_t* out;
+      bool tty;
+    } endpoint_t;
+
+    struct term_output {
+      FILE* fp;           /**< Stream ncurses writes to */
+      int pipe_fd;        /**< Read end of the pipe */
+      int tty_fd;         /**< The terminal, non-blocking */
+      std::string buf;    /**< Bytes not written to the terminal yet */
+      std::size_t off;
+      bool out_armed;     /**< Whether the terminal is watched for writing */
+      bool failed;        /**< Whether writing to the terminal failed */
+      bool closing;
+      bool done;
+      uint64_t deadline;  /**< Time to give up flushing after close */
+      endpoint_t rd;
+      endpoint_t wr;
+    };
+
+    int epoll_fd;
+    int wake_fd;
+
+    std::mutex lock;
+    std::condition_variable cond;
+    std::vector<term_output_t*> outputs;
+
+    output_pump();
+
+    void run();
+    void drain(term_output_t* out);
+    void flush(term_output_t* out);
+    void arm(term_output_t* out, bool armed);
+    void hang_up(term_output_t* out);
+    void remove(term_output_t* out);
+    void wake();
+
+  public:
+    /**
+     * @brief Get the pump, its thread is started on first use.
+     * @return A reference to the pump.
+     */
+    static output_pump& get_instance();
+
+    /**
+     * @brief Start pumping output to a terminal.
+     * @param tty_fd A file descriptor of the terminal, it is reopened or
+     * duplicated.
+     * @return A stream to pass to ncurses as the output of the terminal, NULL
+     * on failure.
+     */
+    FILE* open(int tty_fd);
+
+    /**
+     * @brief Write what has been written to a stream to its terminal, then
+     * stop pumping it. The stream is not closed and must not be written to
+     * anymore.
+     * @param fp The stream returned by open.
+     * @param timeout The time to wait for the terminal in milliseconds, after
+     * which pending output is dropped.
+     */
+    void close(FILE* fp, int timeout);
+  };
+
+}
+
+#endif /* NCUI_OUTPUT_H */
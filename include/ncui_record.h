@@ -0,0 +1,195 @@
+/**
+ * @file ncui_record.h
+ * @author notweerdmonk
+ * @brief Recording of the frames drawn to a terminal, and reading them back.
+ */
+
+#ifndef NCUI_RECORD_H
+#define NCUI_RECORD_H
+
+#include <ncui_common.h>
+
+namespace ncui {
+
+  namespace detail {
+
+    /**
+     * @brief Append an unsigned LEB128 varint to a buffer.
+     * @param buf The buffer.
+     * @param val The number.
+     */
+    void put_varint(std::string& buf, uint64_t val);
+
+    /**
+     * @brief Read an unsigned LEB128 varint from a stream.
+     * @param fp The stream.
+     * @param[out] val The number.
+     * @return false at the end of the stream or if the varint is malformed.
+     */
+    bool get_varint(FILE* fp, uint64_t& val);
+  }
+
+  /**
+   * Kinds of records of a recording.
+   *
+   * A recording starts with the magic "NCUIREC" and a version byte. All
+   * numbers are unsigned LEB128 varints.
+   *
+   * REC_SIZE:  lines, cols. The terminal was resized, every cell is blank.
+   * REC_PAIR:  pair, fg + 1, bg + 1. A color pair was first seen.
+   * REC_FRAME: milliseconds since the previous frame, count of spans, then
+   *            for each span its row as an offset from the row of the
+   *            previous span, its column and length, followed by runs of
+   *            equal cells covering the span, each a count and the cell
+   *            XORed with the cell of the previous run.
+   */
+  typedef enum {
+    REC_SIZE  = 'S',
+    REC_PAIR  = 'P',
+    REC_FRAME = 'F'
+  } rec_kind_t;
+
+  /**
+   * @brief Cells of a row that changed in a frame.
+   */
+  typedef struct {
+    int y;
+    int x;
+    int len;
+    std::size_t off;  /**< Offset of the first cell in the cells of the frame */
+  } rec_span_t;
+
+  /**
+   * @brief A record read from a recording.
+   */
+  typedef struct {
+    rec_kind_t kind;
+    uint64_t time;                /**< Time of a frame since the start, in ms */
+    int lines;
+    int cols;
+    short pair;
+    short fg;
+    short bg;
+    std::vector<rec_span_t> spans;
+    std::vector<chtype> cells;
+  } rec_record_t;
+
+  /**
+   * @brief Records the cells of the current terminal of ncurses that changed
+   * in each frame. Only the damaged regions reported for a frame are
+   * compared with what was recorded before.
+   */
+  class frame_recorder {
+    FILE* fp;
+    uint64_t last;
+    int lines;
+    int cols;
+    bool full;
+
+    /**
+     * Cells as recorded so far.
+     */
+    std::vector<chtype> shadow;
+
+    /**
+     * Damaged columns of each row, lo >= hi if the row is not damaged.
+     */
+    std::vector<int> lo;
+    std::vector<int> hi;
+
+    std::vector<bool> pairs_seen;
+    std::vector<chtype> row;
+    std::string buf;
+    std::string spans;
+    std::size_t written;
+
+    void resize();
+    void note_pairs(const chtype* cells, int len);
+    int encode_row(int y, int& prev_y);
+
+  public:
+    /**
+     * @brief Constructor. Writes the header of the recording.
+     * @param _fp The stream to write to, it is not closed.
+     */
+    explicit frame_recorder(FILE* _fp);
+
+    ~frame_recorder();
+
+    /**
+     * @brief Report a region drawn in the current frame.
+     * @param win The ncurses window that was drawn.
+     */
+    void damage(WINDOW* win);
+
+    /**
+     * @brief Report the whole terminal as drawn in the current frame.
+     */
+    void damage_all();
+
+    /**
+     * @brief Report color pairs whose colors changed. Each is recorded
+     * again when next drawn, and the cells recorded with it are written
+     * again in the next frame.
+     * @param changed The pairs.
+     */
+    void recolor(const std::vector<short>& changed);
+
+    /**
+     * @brief Write the cells of the damaged regions that changed. Must be
+     * called after the frame has been drawn to the terminal.
+     */
+    void frame();
+
+    /**
+     * @return The number of bytes written to the recording.
+     */
+    std::size_t bytes() const;
+  };
+
+  typedef frame_recorder frame_recorder_t;
+
+  /**
+   * @brief Reads back the records of a recording.
+   */
+  class frame_reader {
+    FILE* fp;
+    uint64_t time;
+    int lines;
+    int cols;
+    bool valid;
+    bool malformed;
+
+  public:
+    /**
+     * @brief Constructor. Reads the header of the recording.
+     * @param _fp The stream to read from, it is not closed.
+     */
+    explicit frame_reader(FILE* _fp);
+
+    /**
+     * @return true if the stream starts with a recording header.
+     */
+    bool is_valid() const;
+
+    /**
+     * @brief Read the next record.
+     * @param[out] rec The record, its storage is reused.
+     * @return true if a record was read, false at the end of the recording
+     * or if it is malformed.
+     */
+    bool next(rec_record_t& rec);
+
+    /**
+     * @return true if reading stopped at a record that is cut short,
+     * malformed or out of the bounds of the terminal, false if it stopped
+     * at the end of the recording.
+     */
+    bool is_malformed() const;
+  };
+
+  typedef frame_reader frame_reader_t;
+
+}
+
+#endif /* NCUI_RECORD_H */
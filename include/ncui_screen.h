@@ -10,6 +10,9 @@
 #include <ncui_common.h>
 #include <ncui_types.h>
 #include <ncui_window.h>
+#include <ncui_input.h>
+#include <ncui_style.h>
+#include <ncui_keymap.h>
 
 namespace ncui {
 
@@ -20,6 +23,9 @@ namespace ncui {
     /* Forward declaration of ncui::Screen::ScreenImpl class */
     class ScreenImpl;
 
+    /* ncui::Window tells the event loop when it reads input */
+    friend class Window;
+
     /**
      * A pointer to an instance of ncui::Screen::ScreenImpl class that
      * implements the functionality.
@@ -31,6 +37,38 @@ namespace ncui {
      */
     std::vector<Window*> windows;
 
+    /**
+     * Windows without a parent, from the bottom to the top of the stacking
+     * order. Frames are composed in this order.
+     */
+    std::vector<Window*> stack;
+
+    /**
+     * Scratch list of the windows above the one being drawn.
+     */
+    std::vector<Window*> occluders;
+
+    typedef struct {
+      Window* win;
+      WINDOW* saved;    /**< Cells under the popup when shown, or NULL */
+      int     y;
+      int     x;
+      bool    modal;
+      Window* focus;    /**< Window focused before the popup */
+    } popup_t;
+
+    /**
+     * Stack of popups, the last one is on top.
+     */
+    std::vector<popup_t> popups;
+
+    /**
+     * Windows without a parent that drew lines under popups, paired with the
+     * popups. They are drawn again when the popup is dismissed, the others
+     * are uncovered from the saved cells.
+     */
+    std::vector<std::pair<Window*, Window*> > under;
+
     /**
      * Count of windows added to ncui::Screen.
      */
@@ -42,24 +80,307 @@ namespace ncui {
     Window* focused_win;
 
     /**
-     * Private constructor and destructor to enforce singleton class.
+     * Windows from the root down to the focused window, the dispatch path of
+     * keyboard events. Rebuilt lazily after the focus changes.
+     */
+    std::vector<Window*> focus_path;
+
+    bool focus_path_valid;
+
+    /**
+     * Scratch dispatch path for events not targeting the focused window.
+     */
+    std::vector<Window*> event_path;
+
+    /**
+     * Direction in which windows without a parent that have size constraints
+     * are arranged.
+     */
+    layout_dir_t layout_dir;
+
+    /**
+     * Whether a layout pass is due before the next update.
+     */
+    bool layout_pending;
+
+    /**
+     * Size of the terminal at the last layout pass.
+     */
+    int layout_lines;
+    int layout_cols;
+
+    /**
+     * Saved views, the snapshots of the windows by view id.
+     */
+    std::map<int, std::vector<std::pair<Window*, win_snapshot_t*> > > views;
+
+    /**
+     * Whether the screen is waited on by mainloop_all.
+     */
+    bool looped;
+
+    /**
+     * Depth of dispatches and updates in progress, and of dispatches alone.
+     * Windows destroyed meanwhile are deleted when the outermost one ends,
+     * handlers and frames still walking them see no dangling pointers.
+     */
+    int busy;
+    int dispatch_depth;
+
+    /**
+     * Windows destroyed during a dispatch or an update, in order.
+     */
+    std::vector<Window*> doomed;
+
+    /**
+     * The screen whose terminal is the current one of ncurses.
+     */
+    static Screen* current;
+
+    /**
+     * List of screens, in order of creation.
+     */
+    static std::vector<Screen*> screens;
+
+    /**
+     * Private constructors and destructor, screens are created with
+     * get_instance and create_screen.
      */
     Screen();
+    Screen(const char* type, FILE* out, FILE* in, bool buffered);
     ~Screen();
 
+    /**
+     * @brief Store the windows from the root down to a window.
+     * @param p_win The window at the end of the path.
+     * @param[out] path The path, its storage is reused.
+     */
+    void build_path(Window* p_win, std::vector<Window*>& path);
+
+    /**
+     * @brief Enter a dispatch or an update.
+     */
+    void enter();
+
+    /**
+     * @brief Leave a dispatch or an update, deleting the windows destroyed
+     * meanwhile when the outermost one ends.
+     * @return true if windows were deleted, false otherwise.
+     */
+    bool leave();
+
+    /**
+     * @brief Delete a window later if a dispatch or an update is in progress.
+     * @param win The window.
+     * @return true if it is deleted later, false if it may be deleted now.
+     */
+    bool defer_destroy(Window* win);
+
+    /**
+     * @param win A window.
+     * @return true if the window is destroyed and waits to be deleted.
+     */
+    bool is_doomed(Window* win) {
+      return !doomed.empty() &&
+        (std::find(doomed.begin(), doomed.end(), win) != doomed.end());
+    }
+
     /**
      * @brief Get the exit condition for the event loop.
      * @return true or false.
      */
     bool should_exit();
 
+    /**
+     * @brief Check whether the focused window reads terminal input.
+     * @return true or false.
+     */
+    bool reads_input();
+
+    /**
+     * @brief Tell the event loop that a key was read. ncurses may have
+     * buffered more input, so the next wait does not block.
+     */
+    void note_input();
+
+    /**
+     * @brief Read the next input event for a window from the input source,
+     * the terminal if none is set, and record it if recording input.
+     * @param win The window reading input.
+     * @param[out] ev The event.
+     * @return true if an event was read, false otherwise.
+     */
+    bool read_input(Window* win, input_event_t& ev);
+
+    /**
+     * @brief Get the attributes and color pair to draw a style with.
+     * @param id The id of the style.
+     * @param[out] attrs The attributes.
+     * @param[out] pair The color pair.
+     * @param pin Whether the pair must not be recycled until unpinned.
+     * @return true if the style exists, false otherwise.
+     */
+    bool resolve_style(style_id_t id, attr_t& attrs, short& pair,
+        bool pin = false);
+
+    /**
+     * @brief Unpin the pair pinned by resolving a style.
+     * @param id The id of the style.
+     */
+    void unpin_style(style_id_t id);
+
+    /**
+     * @brief Blank the terminal and draw every realized window again, after
+     * a window without a parent moved or was hidden.
+     */
+    void repaint();
+
+    /**
+     * @brief Update a window and its descendants for the frame being
+     * composed.
+     * @param win The window.
+     * @return true if any of the windows was drawn, false otherwise.
+     */
+    bool compose(Window* win);
+
+    /**
+     * @brief Keep a window from drawing the lines covered by windows above it
+     * in the stacking order. Windows above that partly cover a line it draws
+     * are drawn again over it.
+     * @param win The window about to be drawn.
+     * @return true if any line was left out, false otherwise.
+     */
+    bool cull(Window* win);
+
+    /**
+     * @brief Draw again the windows without a parent overlapping a window.
+     * @param win The window.
+     */
+    void retouch(Window* win);
+
+    /**
+     * @brief Blank the area of a window without a parent that is hidden and
+     * draw again the windows it uncovers.
+     * @param win The window, still realized.
+     */
+    void expose(Window* win);
+
+    /**
+     * @brief Move a window without a parent to the top or the bottom of the
+     * stacking order.
+     * @param win The window.
+     * @param top Boolean flag specifying whether to move the window to the
+     * top or to the bottom.
+     */
+    void restack(Window* win, bool top);
+
+    /**
+     * @brief Find the innermost window of a subtree under a position.
+     * @param win The root of the subtree.
+     * @param y The ordinate.
+     * @param x The abscissa.
+     * @return A pointer to the window, NULL if the position is outside the
+     * subtree.
+     */
+    Window* hit(Window* win, int y, int x);
+
+    /**
+     * @brief Find the popup entry of a window.
+     * @param win The window.
+     * @return A pointer to the entry, NULL if the window is not a popup.
+     */
+    popup_t* find_popup(Window* win);
+
+    /**
+     * @brief Forget the saved cells of the popups overlapping a window whose
+     * cells changed under them, they are uncovered by drawing again.
+     * @param win The window, NULL for all popups.
+     */
+    void drop_saved(Window* win);
+
+    /**
+     * @brief Get the modal popup capturing input.
+     * @return A pointer to the popup, NULL if there is none.
+     */
+    Window* get_modal();
+
   public:
     /**
-     * @brief Get a pointer to the single instance of ncui::Screen class.
-     * @return A pointer to an instance of ncui::Screen class.
+     * @brief Get the screen on the terminal of the process, created on first
+     * use.
+     * @return A reference to an instance of ncui::Screen class.
      */
     static Screen& get_instance();
 
+    /**
+     * @brief Create a screen on a terminal. Any number of screens can be
+     * created, each with its own windows, timers and file descriptor
+     * watchers. The new screen becomes the current one. Output to the
+     * terminal is buffered in memory and written by a thread shared by all
+     * screens, so a terminal that is slow to take it does not hold up the
+     * others.
+     * @param type The terminal type, NULL for the value of the TERM
+     * environment variable.
+     * @param out The output stream of the terminal.
+     * @param in The input stream of the terminal.
+     * @return A pointer to an instance of ncui::Screen class, NULL on failure.
+     */
+    static Screen* create_screen(const char* type, FILE* out, FILE* in);
+
+    /**
+     * @brief Destroy a screen created with create_screen and its windows,
+     * after stopping its render thread. Pending output is written to the
+     * terminal, waiting up to a second. Its
+     * ncurses terminal is freed once all screens are destroyed. The streams
+     * of the terminal are not closed.
+     * @param scr A pointer to an instance of ncui::Screen class.
+     */
+    static void destroy_screen(Screen* scr);
+
+    /**
+     * @brief Get the current screen, which windows created without a parent
+     * or a screen belong to. It is the screen being updated or whose callbacks
+     * are being called, or else the one last activated or created. If there
+     * is none, it is the one returned by get_instance.
+     * @return A reference to an instance of ncui::Screen class.
+     */
+    static Screen& get_current();
+
+    /**
+     * @brief Make the terminal of the screen the current one of ncurses, with
+     * set_term. ncui activates screens as needed, this is only required to
+     * call ncurses directly.
+     */
+    void activate();
+
+    /**
+     * @brief Lock ncurses, whose current terminal is shared by all screens.
+     * The event loops hold the lock while they update windows and call
+     * callbacks, and release it while they wait. Other threads must hold it
+     * to use ncui or ncurses, except for post, start and join. It can be
+     * locked recursively.
+     */
+    static void lock();
+
+    /**
+     * @brief Unlock ncurses.
+     */
+    static void unlock();
+
+    /**
+     * @brief Run the event loop of the screen on a render thread of its own.
+     * Screens started this way are updated in parallel, with their ncurses
+     * calls serialized by lock, and are left alone by mainloop_all.
+     * @return true if the thread was started, false otherwise.
+     */
+    bool start();
+
+    /**
+     * @brief Wait for the render thread of the screen to exit, once the exit
+     * condition of the screen is set.
+     */
+    void join();
+
     /*
      * @brief Create the instance of ncui::Screen class if it does not exists.
      * @return A pointer to an instance of ncui::Screen class.
@@ -67,14 +388,49 @@ namespace ncui {
     static Screen* init();
 
     /**
-     * @brief Enable use of colors in the ncurses screen.
+     * @brief Enable use of colors in the ncurses screen. The default colors
+     * of the terminal are used where supported.
      */
     void enable_color();
 
+    /**
+     * @brief Add a style to draw text with. Colors of styles are mapped to
+     * color pairs of the terminal when they are drawn, recycling the least
+     * recently used pairs when the terminal runs out of them.
+     * @param style The style.
+     * @return The id of the style, the same for equal styles. Ids are valid on
+     * this screen only.
+     */
+    style_id_t add_style(const style_t& style);
+
+    /**
+     * @brief Get the keymap of the screen, the bindings of keys shared by
+     * its windows. Windows inherit changes made to it.
+     * @return A reference to the keymap.
+     */
+    keymap_t& get_keymap();
+
     /**
      * @brief Enable mouse events.
+     * @param motion The motion of the mouse reported, as mouse events with
+     * REPORT_MOUSE_POSITION. Motion read in one go is coalesced to the
+     * latest position over each window, presses and releases are kept.
+     */
+    void enable_mouse_events(mouse_motion_t motion = MOUSE_MOTION_NONE);
+
+    /**
+     * @brief Set how long ncurses waits for the rest of an escape sequence
+     * after an Escape before it is read as the Escape key, 25 ms by default
+     * unless the ESCDELAY environment variable is set. Sequences from slow
+     * connections may need longer.
+     * @param ms The delay in milliseconds.
      */
-    void enable_mouse_events();
+    void set_escape_delay(int ms);
+
+    /**
+     * @return The escape delay in milliseconds.
+     */
+    int get_escape_delay();
 
     /**
      * @brief Set the visibility of the cursor.
@@ -89,7 +445,7 @@ namespace ncui {
     int set_cursor(int visibility);
 
     /**
-     * @brief Set the exit condition for the event loop.
+     * @brief Set the exit condition for the event loop of the current screen.
      */
     static void exit_screen();
 
@@ -104,10 +460,177 @@ namespace ncui {
     void update();
 
     /**
-     * @brief Run the event loop.
+     * @brief Run the event loop. Each iteration runs the posted calls,
+     * expires due timers, updates the windows and then blocks until terminal
+     * input is available, a watched file descriptor is ready or the next
+     * timer is due.
      */
     void mainloop();
 
+    /**
+     * @brief Run the event loop of all screens on the calling thread, until
+     * the exit condition is set for each of them. A screen whose exit
+     * condition is set is left alone and can be destroyed.
+     */
+    static void mainloop_all();
+
+    /**
+     * @brief Add a timer. Its callback is called from the event loop.
+     * @param ms The delay, and the period of a periodic timer, in
+     * milliseconds.
+     * @param cb The callback function.
+     * @param cb_data The data passed to the callback function.
+     * @param periodic Boolean flag specifying whether the timer is periodic.
+     * @return The id of the timer.
+     */
+    timer_id_t add_timer(
+        unsigned long ms,
+        timer_cb_t cb,
+        timer_cb_data_t cb_data,
+        bool periodic = false
+      );
+
+    /**
+     * @brief Cancel a timer. It is safe to cancel a timer from its callback.
+     * @param id The id of the timer.
+     * @return true if the timer was pending, false otherwise.
+     */
+    bool cancel_timer(timer_id_t id);
+
+    /**
+     * @brief Call a function from the next iteration of the event loop, for
+     * work that can not be done while an event is being dispatched. It is
+     * safe to call from any thread and wakes up the event loop.
+     * @param cb The callback function.
+     * @param cb_data The data passed to the callback function.
+     */
+    void post(scr_cb_t cb, scr_cb_data_t cb_data);
+
+    /**
+     * @brief Watch a file descriptor in the event loop, which calls the
+     * callback with the descriptor and its ready events as long as they are
+     * ready. Watching a descriptor again replaces its events and callback.
+     * The descriptor must be unwatched before it is closed.
+     * @param fd The file descriptor, it can not be a regular file or the
+     * terminal.
+     * @param events A bitwise OR of FD_EV_READ and FD_EV_WRITE. FD_EV_HUP and
+     * FD_EV_ERROR are always reported.
+     * @param cb The callback function.
+     * @param cb_data The data passed to the callback function.
+     * @return true on success, false otherwise.
+     */
+    bool watch_fd(int fd, int events, fd_cb_t cb, fd_cb_data_t cb_data);
+
+    /**
+     * @brief Stop watching a file descriptor. It is safe to unwatch a
+     * descriptor from a callback.
+     * @param fd The file descriptor.
+     * @return true if the descriptor was watched, false otherwise.
+     */
+    bool unwatch_fd(int fd);
+
+    /**
+     * @brief Set the direction in which windows without a parent that have
+     * size constraints are arranged on the screen.
+     * @param dir The layout direction.
+     */
+    void set_layout(layout_dir_t dir);
+
+    /**
+     * @brief Schedule a layout pass before the next update.
+     */
+    void request_layout();
+
+    /**
+     * @brief Compute the geometry of the windows that have size constraints.
+     * Only the subtrees whose constraints, or the size of the terminal, changed
+     * since the last pass are laid out again.
+     */
+    void layout();
+
+    /**
+     * @brief Dispatch an event along the window hierarchy. Capturing handlers
+     * are called from the root down to the parent of the target, then the
+     * handlers of the target, then the other handlers from the parent of the
+     * target up to the root, until a handler stops the propagation.
+     * @param ev The window event.
+     * @param e The typed event, its target must be set.
+     * @param cb_data The data passed to callbacks registered with
+     * reg_event_handler, which are called at the target and during the bubble
+     * phase.
+     */
+    void dispatch(win_event_t ev, Event& e, win_ev_cb_data_t cb_data);
+
+    /**
+     * @brief Read input events from a source instead of the terminal, such as
+     * an ncui::input_replayer.
+     * @param src The source, NULL to read from the terminal again. It is not
+     * owned by the screen and must outlive its use.
+     */
+    void set_input_source(input_source* src);
+
+    /**
+     * @brief Record the input events read, with the time between them, to be
+     * replayed by an ncui::input_replayer.
+     * @param fp The stream to write the recording to. It is not closed and
+     * must stay open until the recording is stopped.
+     * @return true if recording started, false if already recording or fp
+     * is NULL.
+     */
+    bool start_recording_input(FILE* fp);
+
+    /**
+     * @brief Stop recording input and flush the recording.
+     */
+    void stop_recording_input();
+
+    /**
+     * @brief Record the cells that change in each frame drawn by update, to
+     * be replayed by tools/ncui_replay. See ncui_record.h for the format.
+     * @param fp The stream to write the recording to. It is not closed and
+     * must stay open until the recording is stopped.
+     * @return true if recording started, false if already recording or fp
+     * is NULL.
+     */
+    bool start_recording(FILE* fp);
+
+    /**
+     * @brief Stop recording and flush the recording.
+     */
+    void stop_recording();
+
+    /**
+     * @brief Save the contents of all windows as a view. The cells are copied
+     * once for each window without a parent.
+     * @param id The id of the view, a view saved with the same id is
+     * replaced.
+     */
+    void save_view(int id);
+
+    /**
+     * @brief Put back the contents of the windows saved in a view, without
+     * calling any callbacks. Windows created after the view was saved keep
+     * their contents.
+     * @param id The id of the view.
+     * @return true if the view exists, false otherwise.
+     */
+    bool restore_view(int id);
+
+    /**
+     * @brief Forget a saved view.
+     * @param id The id of the view.
+     */
+    void drop_view(int id);
+
+    /**
+     * @brief Find the window at given screen-relative coordinates.
+     * @param y The ordinate.
+     * @param x The abscissa.
+     * @return A pointer to the topmost ncui::Window enclosing the
+     * coordinates, NULL if there is none.
+     */
+    Window* window_at(int y, int x);
+
     /**
      * @brief Give focus to a child window.
      * @param p_win A pointer to an object of ncui::Window class that is a
@@ -123,6 +646,40 @@ namespace ncui {
      */
     void set_focus_next(Window *p_win);
 
+    /**
+     * @brief Move focus to previous textfield window.
+     * @param p_win A pointer to an object of ncui::Window class that is a
+     * child. The focus shall move to the previous ncui::Window that is a
+     * textfield, in the list of children.
+     */
+    void set_focus_prev(Window *p_win);
+
+    /**
+     * @brief Show a window without a parent as a popup over the others. The
+     * cells it covers are saved and copied back when it is dismissed, so the
+     * windows under it are only drawn again where they changed meanwhile. A
+     * modal popup captures input: its first textfield takes the focus,
+     * focus only cycles among its textfields and mouse events outside of it
+     * target the focused window.
+     * @param win A pointer to the window, usually created hidden.
+     * @param modal Boolean flag specifying whether the popup is modal.
+     * @return true on success, false if the window has a parent, belongs to
+     * another screen or already is a popup.
+     */
+    bool push_popup(Window* win, bool modal = true);
+
+    /**
+     * @brief Dismiss the popup on top of the stack. It is hidden and the
+     * focus goes back to the window focused before it was shown.
+     */
+    void pop_popup();
+
+    /**
+     * @brief Get the popup on top of the stack.
+     * @return A pointer to the window, NULL if there is none.
+     */
+    Window* get_popup();
+
     /**
      * @brief Print a string at given location.
      * @param y The row to start printing from.
@@ -0,0 +1,153 @@
+/**
+ * @file ncui_style.h
+ * @author notweerdmonk
+ * @brief Styles of text and their cache of ncurses color pairs.
+ */
+
+#ifndef NCUI_STYLE_H
+#define NCUI_STYLE_H
+
+#include <ncui_common.h>
+
+namespace ncui {
+
+  /**
+   * @brief Colors and attributes of text. Colors are ncurses color numbers,
+   * -1 is the default color of the terminal.
+   */
+  typedef struct style {
+    short fg;
+    short bg;
+    attr_t attrs;
+
+    /**
+     * @brief Constructor.
+     * @param _fg The foreground color.
+     * @param _bg The background color.
+     * @param _attrs The attributes, such as A_BOLD.
+     */
+    style(short _fg = -1, short _bg = -1, attr_t _attrs = A_NORMAL) :
+      fg(_fg), bg(_bg), attrs(_attrs) {
+    }
+
+    bool operator==(const style& other) const {
+      return (fg == other.fg) && (bg == other.bg) && (attrs == other.attrs);
+    }
+  } style_t;
+
+  /**
+   * Id of a style added to a screen, 0 is the default style.
+   */
+  typedef int style_id_t;
+
+  /**
+   * @brief A piece of text drawn with a style.
+   */
+  typedef struct {
+    const char* text;
+    int len;            /**< Length of the text, -1 if it is NUL-terminated */
+    style_id_t style;
+  } styled_span_t;
+
+  /**
+   * @brief Interns styles and maps their colors to ncurses color pairs.
+   *
+   * Pairs are allocated on first use and recycled in least recently used
+   * order once the terminal runs out of them, so resolving a style is O(1)
+   * and init_pair is only called when a pair is allocated or recycled.
+   * Cells still showing a recycled pair take its new colors. Pinned pairs,
+   * used by window backgrounds and borders, are never recycled.
+   */
+  class style_cache {
+
+    enum {
+      NIL = 0   /**< Pair 0 is never allocated, it ends the lists */
+    };
+
+    typedef struct {
+      uint32_t key;   /**< Colors of the pair */
+      int refs;       /**< Number of pins, pinned pairs are not in the list */
+      short prev;
+      short next;
+    } pair_slot_t;
+
+    std::vector<style_t> styles;
+
+    /**
+     * Pair last resolved for each style, checked against its slot.
+     */
+    std::vector<short> style_pairs;
+
+    std::unordered_map<uint64_t, style_id_t> ids;
+
+    std::vector<pair_slot_t> slots;
+    std::unordered_map<uint32_t, short> pairs;
+    short head;   /**< Most recently used pair */
+    short tail;   /**< Least recently used pair */
+    int max_pairs;
+    bool colors;
+    bool default_colors;
+    unsigned long inits;
+
+    /**
+     * Pairs recycled since they were last taken.
+     */
+    std::vector<short> recycled;
+
+    static uint32_t color_key(short fg, short bg);
+    void link(short pair);
+    void unlink(short pair);
+    short acquire(short fg, short bg);
+
+  public:
+    style_cache();
+
+    /**
+     * @brief Forget the allocated pairs and use the colors of the current
+     * terminal of ncurses. Called after start_color.
+     */
+    void reset();
+
+    /**
+     * @brief Intern a style.
+     * @param s The style.
+     * @return The id of the style, the same for equal styles.
+     */
+    style_id_t add(const style_t& s);
+
+    /**
+     * @brief Get the attributes and color pair to draw a style with,
+     * allocating the pair if required.
+     * @param id The id of the style.
+     * @param[out] attrs The attributes.
+     * @param[out] pair The color pair, 0 if colors are not enabled or all
+     * pairs are pinned.
+     * @param pin Whether to pin the pair, it is unpinned with unpin.
+     * @return true if the style exists, false otherwise.
+     */
+    bool resolve(style_id_t id, attr_t& attrs, short& pair, bool pin = false);
+
+    /**
+     * @brief Unpin the pair pinned by resolving a style.
+     * @param id The id of the style.
+     */
+    void unpin(style_id_t id);
+
+    /**
+     * @brief Take the pairs recycled since the last call, so that whatever
+     * remembers their previous colors can forget them.
+     * @param[out] out The pairs, a pair may appear more than once.
+     */
+    void take_recycled(std::vector<short>& out);
+
+    /**
+     * @return The number of calls to init_pair so far.
+     */
+    unsigned long get_inits() const;
+  };
+
+  typedef style_cache style_cache_t;
+
+}
+
+#endif /* NCUI_STYLE_H */
@@ -0,0 +1,118 @@
+/**
+ * @file ncui_timer.h
+ * @author notweerdmonk
+ * @brief Hierarchical timer wheel with millisecond resolution.
+ */
+
+#ifndef NCUI_TIMER_H
+#define NCUI_TIMER_H
+
+#include <ncui_common.h>
+#include <ncui_types.h>
+
+namespace ncui {
+
+  /**
+   * @brief Get the time of a monotonic clock.
+   * @return The time in milliseconds.
+   */
+  uint64_t monotonic_ms();
+
+  /**
+   * @brief A hierarchical timer wheel. Level 0 has one slot per millisecond,
+   * each higher level has slots covering a whole turn of the level below.
+   * Timers are cascaded to lower levels as time advances, so adding,
+   * cancelling and expiring a timer are O(1), and finding the next deadline
+   * is a few bit scans.
+   */
+  typedef struct timer_wheel {
+
+    enum {
+      LEVEL_BITS = 6,
+      SLOTS = 1 << LEVEL_BITS,
+      LEVELS = 4,
+      NIL = -1,
+      EXPIRING = LEVELS * SLOTS   /**< List of timers being expired */
+    };
+
+    typedef struct {
+      uint64_t        expires;
+      uint64_t        period;
+      timer_cb_t      cb;
+      timer_cb_data_t cb_data;
+      uint32_t        gen;
+      int             prev;
+      int             next;
+      int             list;
+    } timer_node_t;
+
+    /**
+     * Time up to which timers have been expired, in milliseconds.
+     */
+    uint64_t now;
+
+    std::vector<timer_node_t> nodes;
+    int free_head;
+
+    int heads[LEVELS * SLOTS + 1];
+    uint64_t occupied[LEVELS];
+
+    /**
+     * @brief Constructor.
+     * @param _now The current time in milliseconds.
+     */
+    timer_wheel(uint64_t _now);
+
+    /**
+     * @brief Add a timer.
+     * @param expires The time of expiry in milliseconds.
+     * @param period The period in milliseconds, 0 for a one-shot timer.
+     * @param cb The callback function.
+     * @param cb_data The data passed to the callback function.
+     * @return The id of the timer.
+     */
+    timer_id_t add(
+        uint64_t expires,
+        uint64_t period,
+        timer_cb_t cb,
+        timer_cb_data_t cb_data
+      );
+
+    /**
+     * @brief Cancel a timer. Ids of expired or cancelled timers are ignored.
+     * @param id The id of the timer.
+     * @return true if the timer was pending, false otherwise.
+     */
+    bool cancel(timer_id_t id);
+
+    /**
+     * @brief Expire the timers due up to given time and call their callbacks.
+     * Periodic timers are added again before their callback is called.
+     * @param _now The current time in milliseconds.
+     * @return The number of timers expired.
+     */
+    int advance(uint64_t _now);
+
+    /**
+     * @brief Get the time until the next timer may expire. For timers on
+     * higher levels this is when they are cascaded, which is never later than
+     * their expiry.
+     * @param _now The current time in milliseconds.
+     * @return The time in milliseconds, -1 if there are no timers.
+     */
+    int next_timeout(uint64_t _now);
+
+  private:
+    void link(int idx, int list);
+    void unlink(int idx);
+    void schedule(int idx);
+    void cascade(int level);
+    void expire();
+    int alloc_node();
+    void free_node(int idx);
+
+  } timer_wheel_t;
+
+}
+
+#endif /* NCUI_TIMER_H */
@@ -26,6 +26,26 @@ namespace ncui {
   typedef base_cb_data_t win_ev_user_data_t;
   
   typedef void* (*win_ev_cb_t)(win_ev_cb_data_t, win_ev_user_data_t);
+  
+  typedef base_cb_data_t timer_cb_data_t;
+  
+  typedef base_cb_t timer_cb_t;
+  
+  typedef unsigned long long timer_id_t;
+
+  /**
+   * Events of a file descriptor watched by the event loop.
+   */
+  typedef enum {
+    FD_EV_READ  = 1 << 0, /**< Readable */
+    FD_EV_WRITE = 1 << 1, /**< Writable */
+    FD_EV_HUP   = 1 << 2, /**< Hung up, always reported */
+    FD_EV_ERROR = 1 << 3  /**< Error condition, always reported */
+  } fd_event_t;
+
+  typedef base_cb_data_t fd_cb_data_t;
+
+  typedef void* (*fd_cb_t)(int, int, fd_cb_data_t);
 }
 
 #endif /* NCUI_TYPES_H */
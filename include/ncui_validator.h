@@ -0,0 +1,130 @@
+/**
+ * @file ncui_validator.h
+ * @author notweerdmonk
+ * @brief Constraints on the text of a textfield and their compiled
+ * validator.
+ */
+
+#ifndef NCUI_VALIDATOR_H
+#define NCUI_VALIDATOR_H
+
+#include <ncui_common.h>
+
+namespace ncui {
+
+  /**
+   * @brief Constraints on each line of a textfield. Keys breaking them are
+   * rejected before they reach the text of the textfield.
+   *
+   * A mask has a character for each column of the line:
+   * - '9' a digit
+   * - 'A' a letter
+   * - 'X' a letter or a digit
+   * - 'H' a hexadecimal digit
+   * - '*' any printable character
+   * - '\\' the next character is a literal
+   * - any other character is a literal, typed by the user or inserted when
+   *   the key typed is accepted by the column after it, printable ASCII only
+   *
+   * A mask takes precedence over numeric. The charset, if any, further
+   * restricts every column that is not a literal.
+   */
+  typedef struct field_constraints {
+    int max_len;          /**< Characters in a line, 0 for no limit */
+    bool numeric;         /**< A number with an optional leading '-' */
+    int decimals;         /**< Digits after the decimal point of a number */
+    const char* mask;     /**< Mask of the line, NULL for none */
+    const char* charset;  /**< Allowed characters, ranges such as "a-z" are
+                            allowed, NULL for any printable character */
+
+    /**
+     * @brief Constructor.
+     * @param _max_len The maximum number of characters in a line.
+     */
+    field_constraints(int _max_len = 0) :
+      max_len(_max_len), numeric(false), decimals(0), mask(NULL),
+      charset(NULL) {
+    }
+  } field_constraints_t;
+
+  /**
+   * @brief Field constraints compiled to a table driven state machine.
+   *
+   * The state after each character of a line is looked up in a table of 128
+   * entries per state, so checking a key is a bounds check and a load. State
+   * 0 rejects every key.
+   */
+  class field_validator {
+
+    enum {
+      ASCII = 128,
+      MAX_STATES = 255
+    };
+
+    /**
+     * Next state for each state and key, ASCII entries per state.
+     */
+    std::vector<uint8_t> table;
+
+    /**
+     * Literal expected in each state of a mask, 0 if none.
+     */
+    std::vector<char> literals;
+
+    int max_len;
+
+    int add_state();
+    void allow(int state, const bool* set, int next);
+
+  public:
+    enum {
+      REJECT = 0,
+      START = 1
+    };
+
+    /**
+     * @brief Constructor. Compile the constraints.
+     * @param c The constraints.
+     * @throw std::invalid_argument if the mask is longer than 254 columns
+     * or has a character that is not printable ASCII.
+     */
+    field_validator(const field_constraints_t& c);
+
+    /**
+     * @brief Get the state after a key.
+     * @param state The state before the key.
+     * @param col The column the key is typed at.
+     * @param key The key.
+     * @return The next state, REJECT if the key is not accepted.
+     */
+    int step(int state, int col, int key) const {
+      if ((key < 0) || (key >= ASCII) ||
+          ((max_len > 0) && (col >= max_len))) {
+        return REJECT;
+      }
+      return table[(state * ASCII) + key];
+    }
+
+    /**
+     * @brief Get the literal a mask expects in a state.
+     * @param state The state.
+     * @return The literal, 0 if the state does not expect one.
+     */
+    char literal(int state) const {
+      return literals[state];
+    }
+
+    /**
+     * @brief Get the state after a prefix of a line.
+     * @param str The line.
+     * @param len The length of the prefix, it ends at a NUL byte otherwise.
+     * @return The state, REJECT if the prefix breaks the constraints.
+     */
+    int run(const char* str, int len) const;
+  };
+
+  typedef field_validator field_validator_t;
+
+}
+
+#endif /* NCUI_VALIDATOR_H */
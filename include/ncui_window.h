@@ -10,9 +10,21 @@
 #include <ncui_common.h>
 #include <ncui_types.h>
 #include <ncui_field_buffer.h>
+#include <ncui_layout.h>
+#include <ncui_event.h>
+#include <ncui_style.h>
+#include <ncui_validator.h>
+#include <ncui_keymap.h>
 
 namespace ncui {
 
+  class Screen;
+
+  /**
+   * The saved contents of a window, opaque.
+   */
+  typedef struct win_snapshot win_snapshot_t;
+
   /**
    * Events that can occur on an window.
    */
@@ -25,6 +37,15 @@ namespace ncui {
     WIN_EV_MAX        /**< Guard value */
   } win_event_t;
 
+  /**
+   * Kinds of borders of windows.
+   */
+  typedef enum {
+    BORDER_LINE,      /**< Line drawing characters */
+    BORDER_ASCII,     /**< '+', '-' and '|' */
+    BORDER_INVISIBLE  /**< Blank cells, the title is still shown */
+  } border_t;
+
   /**
    * @brief A class to manage ncurses windows.
    */
@@ -32,6 +53,9 @@ namespace ncui {
     /* Forward declaration of ncui::Window::WindowImpl class */
     class WindowImpl;
 
+    /* ncui::Screen lays out the top level windows */
+    friend class Screen;
+
     /**
      * A pointer to an instance of ncui::Window::WindowImpl class that
      * implements the functionality.
@@ -40,15 +64,28 @@ namespace ncui {
 
     Window* parent_window;
 
+    /**
+     * The screen the window belongs to, the one of its parent if it has one.
+     */
+    Screen* screen;
+
     std::vector<Window*> children;
 
   private:
     /**
      * @brief Get the ncurses WINDOW pointer for the current window.
-     * @return A ncurses WINDOW pointer.
+     * @return A ncurses WINDOW pointer, NULL if the window is not realized.
      */
     WINDOW *get_win_handle();
 
+    /**
+     * @brief Update the window for a frame composed by its screen. A window
+     * that is drawn is only copied to the virtual screen of ncurses, the
+     * frame is output once complete.
+     * @return true if the ncurses window was drawn, false otherwise.
+     */
+    bool compose();
+
     /**
      * @brief Add a child window.
      * @pram child A pointer to ncui::Window object to add to the list of
@@ -68,6 +105,56 @@ namespace ncui {
      */
     void box();
 
+    /**
+     * @brief Check if the geometry of the window is computed by the layout.
+     * @return true or false.
+     */
+    bool is_managed();
+
+    /**
+     * @brief Get the size constraints of the window.
+     * @param[out] h The constraint on the height.
+     * @param[out] w The constraint on the width.
+     */
+    void get_size(size_spec_t& h, size_spec_t& w);
+
+    /**
+     * @brief Mark the window and its ancestors for layout and schedule a
+     * layout pass.
+     */
+    void invalidate_layout();
+
+    /**
+     * @brief Call the handlers of the window for the current phase of an
+     * event.
+     * @param ev The window event.
+     * @param e The typed event.
+     * @param cb_data The data passed to the callback registered with
+     * reg_event_handler.
+     */
+    void notify(win_event_t ev, const Event& e, win_ev_cb_data_t cb_data);
+
+    /**
+     * @brief Apply the geometry assigned by the parent and lay out the
+     * children. Subtrees whose geometry and constraints did not change are
+     * skipped.
+     * @param h The height of the window.
+     * @param w The width of the window.
+     * @param y The ordinate of the window, relative to the parent.
+     * @param x The abscissa of the window, relative to the parent.
+     * @param force Lay out the window even if its geometry did not change.
+     * @return true if the window was laid out again, false otherwise.
+     */
+    bool layout(int h, int w, int y, int x, bool force);
+
+    /**
+     * @brief Save the contents of the window.
+     * @param cells Whether to copy the cells, which windows with a parent
+     * share with it.
+     * @return A pointer to the snapshot.
+     */
+    win_snapshot_t* snapshot(bool cells);
+
     /**
      * @brief Constructor.
      * Creates a new window without a parent.
@@ -79,12 +166,41 @@ namespace ncui {
      * bordered or not.
      * @param _is_textfield Boolean flag specifying whether the window is a
      * text field or not.
+     * @param _is_visible Boolean flag specifying whether the window is
+     * shown. The ncurses window of a hidden window is created when it is
+     * first shown.
      */
     Window(
         const int _h, const int _w,
         const int _y, const int _x,
         bool _is_bordered = 0,
-        bool _is_textfield = 0
+        bool _is_textfield = 0,
+        bool _is_visible = true
+      );
+
+    /**
+     * @brief Constructor.
+     * Creates a new window without a parent on given screen.
+     * @param p_scr A pointer to ncui::Screen object.
+     * @param _h The height of the window.
+     * @param _w The width of the window.
+     * @param _y The ordinate of the window.
+     * @param _x The abscissa of the window.
+     * @param _is_bordered Boolean flag specifying whether the window should be
+     * bordered or not.
+     * @param _is_textfield Boolean flag specifying whether the window is a
+     * text field or not.
+     * @param _is_visible Boolean flag specifying whether the window is
+     * shown. The ncurses window of a hidden window is created when it is
+     * first shown.
+     */
+    Window(
+        Screen* p_scr,
+        const int _h, const int _w,
+        const int _y, const int _x,
+        bool _is_bordered = 0,
+        bool _is_textfield = 0,
+        bool _is_visible = true
       );
 
     /**
@@ -99,13 +215,17 @@ namespace ncui {
      * bordered or not.
      * @param _is_textfield Boolean flag specifying whether the window is a
      * text field or not.
+     * @param _is_visible Boolean flag specifying whether the window is
+     * shown. The ncurses window of a hidden window is created when it is
+     * first shown.
      */
     Window(
         Window* p_parent_win,
         const int _h, const int _w,
         const int _y, const int _x,
         bool _is_bordered = 0,
-        bool _is_textfield = 0
+        bool _is_textfield = 0,
+        bool _is_visible = true
       );
 
     /**
@@ -116,7 +236,8 @@ namespace ncui {
 
   public:
     /**
-     * @brief A static function to create a new window without a parent.
+     * @brief A static function to create a new window without a parent on the
+     * current screen.
      * @param _h The height of the window.
      * @param _w The width of the window.
      * @param _y The ordinate of the window.
@@ -125,13 +246,43 @@ namespace ncui {
      * bordered or not.
      * @param _is_textfield Boolean flag specifying whether the window is a
      * text field or not.
+     * @param _is_visible Boolean flag specifying whether the window is
+     * shown. The ncurses window of a hidden window is created when it is
+     * first shown.
      * @return A pointer to ncui::Window object.
      */
     static Window* create_window(
         const int _h, const int _w,
         const int _y, const int _x,
         bool _is_bordered = 0,
-        bool _is_textfield = 0
+        bool _is_textfield = 0,
+        bool _is_visible = true
+      );
+
+    /**
+     * @brief A static function to create a new window without a parent on
+     * given screen.
+     * @param p_scr A pointer to ncui::Screen object.
+     * @param _h The height of the window.
+     * @param _w The width of the window.
+     * @param _y The ordinate of the window.
+     * @param _x The abscissa of the window.
+     * @param _is_bordered Boolean flag specifying whether the window should be
+     * bordered or not.
+     * @param _is_textfield Boolean flag specifying whether the window is a
+     * text field or not.
+     * @param _is_visible Boolean flag specifying whether the window is
+     * shown. The ncurses window of a hidden window is created when it is
+     * first shown.
+     * @return A pointer to ncui::Window object.
+     */
+    static Window* create_window(
+        Screen* p_scr,
+        const int _h, const int _w,
+        const int _y, const int _x,
+        bool _is_bordered = 0,
+        bool _is_textfield = 0,
+        bool _is_visible = true
       );
 
     /**
@@ -146,6 +297,9 @@ namespace ncui {
      * bordered or not.
      * @param _is_textfield Boolean flag specifying whether the window is a
      * text field or not.
+     * @param _is_visible Boolean flag specifying whether the window is
+     * shown. The ncurses window of a hidden window is created when it is
+     * first shown.
      * @return A pointer to ncui::Window object.
      */
     static Window* create_window(
@@ -153,7 +307,8 @@ namespace ncui {
         const int _h, const int _w,
         const int _y, const int _x,
         bool _is_bordered = 0,
-        bool _is_textfield = 0
+        bool _is_textfield = 0,
+        bool _is_visible = true
       );
 
     /**
@@ -162,6 +317,12 @@ namespace ncui {
      */
     static void destroy_win(Window *_win);
 
+    /**
+     * @brief Get the screen the window belongs to.
+     * @return A pointer to ncui::Screen object.
+     */
+    Screen* get_screen();
+
     /**
      * @brief Regsiter window update callback.
      * @param cb The callback function.
@@ -193,7 +354,54 @@ namespace ncui {
     void dereg_cb(win_event_t ev);
 
     /**
-     * @brief Print a string in the window at given coordinates.
+     * @brief Subscribe a handler to arrow and function keys. Any number of
+     * handlers can be subscribed, they are called in order of subscription.
+     * Events targeting descendants of the window are seen during the capture
+     * phase by capturing handlers, and during the bubble phase by the others.
+     * @param handler The handler.
+     * @param capture Boolean flag specifying whether the handler is called
+     * during the capture phase instead of the bubble phase.
+     * @return The id of the subscription.
+     */
+    int on_key(const key_handler_t& handler, bool capture = false);
+
+    /**
+     * @brief Subscribe a handler to ASCII characters typed in a textfield.
+     * @param handler The handler.
+     * @param capture Boolean flag specifying whether the handler is called
+     * during the capture phase instead of the bubble phase.
+     * @return The id of the subscription.
+     */
+    int on_term(const key_handler_t& handler, bool capture = false);
+
+    /**
+     * @brief Subscribe a handler to mouse events.
+     * @param handler The handler.
+     * @param capture Boolean flag specifying whether the handler is called
+     * during the capture phase instead of the bubble phase.
+     * @return The id of the subscription.
+     */
+    int on_mouse(const mouse_handler_t& handler, bool capture = false);
+
+    /**
+     * @brief Subscribe a handler to changes of geometry by the layout. Resize
+     * events are only delivered to the window that was resized.
+     * @param handler The handler.
+     * @param capture Unused, resize events do not propagate.
+     * @return The id of the subscription.
+     */
+    int on_resize(const resize_handler_t& handler, bool capture = false);
+
+    /**
+     * @brief Remove a handler. It is safe to call from within a handler.
+     * @param id The id of the subscription.
+     */
+    void unsubscribe(int id);
+
+    /**
+     * @brief Print a string in the window at given coordinates. Nothing is
+     * printed in a window that is not realized, except in the content of a
+     * scrollable window.
      * @param y The ordinate.
      * @param x The abscissa.
      * @param str The std::string object to print.
@@ -206,6 +414,136 @@ namespace ncui {
      */
     void print(std::string str);
 
+    /**
+     * @brief Print a string in the window at given coordinates with a style.
+     * @param y The ordinate.
+     * @param x The abscissa.
+     * @param str The std::string object to print.
+     * @param style The id of a style added to the screen of the window.
+     */
+    void print(int y, int x, std::string str, style_id_t style);
+
+    /**
+     * @brief Print a line of styled spans in the window at given coordinates.
+     * Adjacent spans of the same style are written as a single run. Text
+     * beyond the right edge is cut.
+     * @param y The ordinate.
+     * @param x The abscissa.
+     * @param spans The spans.
+     * @param count The number of spans.
+     */
+    void print(int y, int x, const styled_span_t* spans, std::size_t count);
+
+    /**
+     * @brief Print a line of styled spans in the window at given coordinates.
+     * @param y The ordinate.
+     * @param x The abscissa.
+     * @param spans The spans.
+     */
+    void print(int y, int x, const std::vector<styled_span_t>& spans);
+
+    /**
+     * @brief Back the window with a pad holding content larger than the
+     * window. Printing then writes to the content, at coordinates of the
+     * content, and the window shows the part of it at the scroll position.
+     * Scrolling copies that part from the pad without printing again.
+     * Calling it again resizes the content, keeping what fits.
+     * @param rows The number of rows of the content.
+     * @param cols The number of columns of the content.
+     * @return true on success, false if the window is a textfield or the pad
+     * could not be created.
+     */
+    bool set_scrollable(int rows, int cols);
+
+    /**
+     * @brief Scroll the content of a scrollable window so that given row and
+     * column are at the top left. The position is clamped to the content.
+     * @param row The row.
+     * @param col The column.
+     */
+    void scroll_to(int row, int col);
+
+    /**
+     * @brief Scroll the content of a scrollable window relative to its
+     * current position.
+     * @param rows The row offset, negative or positive.
+     * @param cols The column offset, negative or positive.
+     */
+    void scroll_by(int rows, int cols);
+
+    /**
+     * @brief Get the scroll position of a scrollable window.
+     * @param[out] row The row at the top.
+     * @param[out] col The column at the left.
+     */
+    void get_scroll(int& row, int& col);
+
+    /**
+     * @brief Find and highlight the text of the window matching a query,
+     * the content of a scrollable window or the text of a textfield. Calls
+     * as the query is typed are incremental: the matches of a longer query
+     * are looked for among those of its prefix, going back to a prefix
+     * reuses its matches, and only rows that changed since the last call
+     * are searched again. Matches do not span rows. Only those in the
+     * viewport of a scrollable window are highlighted.
+     * @param query The text to find, empty to clear the matches.
+     * @return The number of matches.
+     */
+    int find(const std::string& query);
+
+    /**
+     * @brief Make the next match of the last query the current one,
+     * scrolling a scrollable window to show it. The first is the first
+     * match in the viewport.
+     * @param forward Whether to move to the next or the previous match,
+     * wrapping around.
+     * @return true if there is a match, false otherwise.
+     */
+    bool find_next(bool forward = true);
+
+    /**
+     * @brief Make the next match of the last query the current one.
+     * @param[out] row The row of the match in the content.
+     * @param[out] col The column of the match in the content.
+     * @param forward Whether to move to the next or the previous match.
+     * @return true if there is a match, false otherwise.
+     */
+    bool find_next(int& row, int& col, bool forward = true);
+
+    /**
+     * @brief Set the styles matches are highlighted with.
+     * @param match The style of matches, 0 for reverse video.
+     * @param current The style of the current match, 0 for bold reverse
+     * video.
+     */
+    void set_find_styles(style_id_t match, style_id_t current);
+
+    /**
+     * @brief Set the style of the background of the window, applied to all
+     * of its cells.
+     * @param style The id of a style added to the screen of the window.
+     */
+    void set_background(style_id_t style);
+
+    /**
+     * @brief Set the style of the border of the window.
+     * @param style The id of a style added to the screen of the window.
+     */
+    void set_border_style(style_id_t style);
+
+    /**
+     * @brief Set the kind of border of a window created with a border.
+     * @param kind The kind of border.
+     */
+    void set_border(border_t kind);
+
+    /**
+     * @brief Set the title shown in the top border of a window created with
+     * a border, cut to fit.
+     * @param title The title, empty for none.
+     */
+    void set_title(const std::string& title);
+
     /**
      * @brief Move the ncurses window to given coordinates.
      * @param _y The ordinate.
@@ -213,6 +551,22 @@ namespace ncui {
      */
     void move(int _y, int _x);
 
+    /**
+     * @brief Set the direction in which the window arranges its children
+     * that have size constraints.
+     * @param dir The layout direction.
+     */
+    void set_layout(layout_dir_t dir);
+
+    /**
+     * @brief Set the size constraints of the window. The geometry of the
+     * window is then computed by the layout of its parent, or of the
+     * ncui::Screen for a window without a parent.
+     * @param h The constraint on the height.
+     * @param w The constraint on the width.
+     */
+    void set_size(size_spec_t h, size_spec_t w);
+
     /**
      * @brief Move the curser to given coordinates.
      * @param _y The ordinate.
@@ -247,8 +601,9 @@ namespace ncui {
     /**
      * @brief Call the window update callback and draw the ncurses window if
      * required.
+     * @return true if the ncurses window was drawn, false otherwise.
      */
-    void update();
+    bool update();
 
     /**
      * @brief Get a character from the ncurses window.
@@ -269,6 +624,79 @@ namespace ncui {
      */
     void bksp();
 
+    /**
+     * @brief Get the text of a textfield without copying it.
+     * @return A view of the lines of the text, empty if the window is not a
+     * textfield or has no text yet. It is valid until the text is changed or
+     * the window is resized or destroyed.
+     */
+    text_view_t text();
+
+    /**
+     * @brief Replace the text of a textfield, drawn once with the next
+     * frame. Lines longer than the textfield are cut and lines past its last
+     * row are dropped.
+     * @param text The text, lines are separated by newline characters.
+     * @param len The length of the text.
+     * @return true if the window is a textfield, false otherwise.
+     */
+    bool set_text(const char* text, std::size_t len);
+
+    /**
+     * @brief Replace the text of a textfield.
+     * @param text The text, lines are separated by newline characters.
+     * @return true if the window is a textfield, false otherwise.
+     */
+    bool set_text(const std::string& text);
+
+    /**
+     * @brief Undo the last edit of the text of a textfield. Characters typed
+     * are undone a word at a time, and backspaces and newlines as they were
+     * typed in a row. Ctrl-_ undoes an edit in a textfield.
+     * @return true if an edit was undone, false if there is none.
+     */
+    bool undo();
+
+    /**
+     * @brief Redo the last edit undone, until the text is edited again.
+     * Ctrl-R redoes an edit in a textfield.
+     * @return true if an edit was redone, false if there is none.
+     */
+    bool redo();
+
+    /**
+     * @brief Set the maximum number of edits kept to be undone, 64 by
+     * default. Edits kept are forgotten, as they are when the text is
+     * replaced or the textfield is resized.
+     * @param edits The number of edits, 0 to keep none.
+     */
+    void set_undo_limit(int edits);
+
+    /**
+     * @brief Get the keymap of the window, created on the first call. It
+     * inherits the bindings of the keymap of the screen, bindings made in it
+     * apply to keys typed while the window has the focus.
+     * @return A reference to the keymap.
+     */
+    keymap_t& get_keymap();
+
+    /**
+     * @brief Constrain what can be typed in each line of a textfield. Keys
+     * breaking the constraints are dropped before they are put in the text,
+     * and no event is dispatched for them. Literals of a mask inserted for
+     * the user are not dispatched either.
+     * @param c The constraints, compiled when set.
+     * @return true if the window is a textfield, false otherwise.
+     * @throw std::invalid_argument if the mask is too long or has a character
+     * that is not printable ASCII.
+     */
+    bool set_constraints(const field_constraints_t& c);
+
+    /**
+     * @brief Accept any printable character in a textfield.
+     */
+    void clear_constraints();
+
     /**
      * @brief Set or unset focus on the ncurses window.
      * @param focus Boolean flag to set or unset focus.
@@ -292,6 +720,72 @@ namespace ncui {
      * @return true or falase.
      */
     bool enclose(int y, int x);
+
+    /**
+     * @brief Show a hidden window. Its ncurses window, and those of its
+     * visible descendants, are created if required and its saved cells are
+     * put back. Resize handlers are notified when the ncurses window is
+     * created, to print the content of windows other than textfields and
+     * scrollable windows, which is not kept without it.
+     */
+    void show();
+
+    /**
+     * @brief Hide the window and its descendants and blank its area.
+     * Derived windows keep a copy of their cells, and windows without a
+     * parent their ncurses window, to be shown again as they were.
+     * @param release Boolean flag specifying whether the ncurses windows
+     * and the cells are released instead. The text of textfields and the
+     * content of scrollable windows are kept.
+     */
+    void hide(bool release = false);
+
+    /**
+     * @brief Move a window without a parent to the top of the stacking
+     * order, over the other windows. Windows are stacked in order of
+     * creation. Derived windows are drawn in the cells of their parent and
+     * are not stacked.
+     */
+    void raise();
+
+    /**
+     * @brief Move a window without a parent to the bottom of the stacking
+     * order, under the other windows.
+     */
+    void lower();
+
+    /**
+     * @brief Check if the window and its ancestors are shown.
+     * @return true or false.
+     */
+    bool is_visible();
+
+    /**
+     * @brief Check if the ncurses window of the window exists.
+     * @return true or false.
+     */
+    bool is_realized();
+
+    /**
+     * @brief Save the contents of the window: its cells, including those of
+     * its children, the cursor and the text of a textfield.
+     * @return A pointer to the snapshot, to be destroyed with
+     * destroy_snapshot.
+     */
+    win_snapshot_t* snapshot();
+
+    /**
+     * @brief Put back saved contents with a single copy, without calling any
+     * callbacks. A snapshot of a window of another size is clipped.
+     * @param snap A pointer to the snapshot.
+     */
+    void restore(const win_snapshot_t* snap);
+
+    /**
+     * @brief A static function to destroy a snapshot.
+     * @param snap A pointer to the snapshot.
+     */
+    static void destroy_snapshot(win_snapshot_t* snap);
   };
 
 }
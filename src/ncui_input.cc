@@ -0,0 +1,356 @@
+/*
+ * @file ncui_input.cc
+ * @author notweerdmonk
+ * @brief Record and replay input events.
+ */
+
+#include <ncui_input.h>
+#include <ncui_record.h>
+#include <ncui_timer.h>
+
+using namespace ncui;
+
+using detail::put_varint;
+using detail::get_varint;
+
+static const char input_magic[] = "NCUIKEY";
+
+static const int input_version = 1;
+
+input_source::~input_source() {
+}
+
+input_recorder::input_recorder(FILE* _fp) :
+  fp(_fp), last(0), started(false) {
+
+  fwrite(input_magic, 1, sizeof(input_magic) - 1, fp);
+  fputc(input_version, fp);
+}
+
+input_recorder::~input_recorder() {
+  fflush(fp);
+}
+
+void input_recorder::record(const input_event_t& ev) {
+  if (!started) {
+    last = ev.time;
+    started = true;
+  }
+
+  buf.clear();
+  put_varint(buf, ev.time - last);
+  put_varint(buf, ev.key);
+  if (ev.key == KEY_MOUSE) {
+    put_varint(buf, ev.mouse.y);
+    put_varint(buf, ev.mouse.x);
+    put_varint(buf, ev.mouse.bstate);
+  }
+  fwrite(buf.data(), 1, buf.size(), fp);
+
+  last = ev.time;
+}
+
+input_replayer::input_replayer(FILE* _fp, bool _realtime) :
+  fp(_fp), realtime(_realtime), valid(false), done(false), has_next(false),
+  started(false), start(0), offset(0), count(0) {
+
+  char magic[sizeof(input_magic)];
+  if (fread(magic, 1, sizeof(magic), fp) == sizeof(magic)) {
+    valid = (memcmp(magic, input_magic, sizeof(input_magic) - 1) == 0) &&
+      (magic[sizeof(input_magic) - 1] == input_version);
+  }
+  done = !valid;
+}
+
+bool input_replayer::fetch() {
+  if (has_next || done) {
+    return has_next;
+  }
+
+  uint64_t delay, key;
+  if (!get_varint(fp, delay) || !get_varint(fp, key)) {
+    done = true;
+    return false;
+  }
+
+  memset(&next, 0, sizeof(next));
+  if (key == KEY_MOUSE) {
+    uint64_t y, x, bstate;
+    if (!get_varint(fp, y) || !get_varint(fp, x) ||
+        !get_varint(fp, bstate)) {
+      done = true;
+      return false;
+    }
+    next.mouse.y = (int)y;
+    next.mouse.x = (int)x;
+    next.mouse.bstate = (mmask_t)bstate;
+  }
+
+  offset += delay;
+  next.time = offset;
+  next.key = (int)key;
+  has_next = true;
+  return true;
+}
+
+bool input_replayer::is_valid() const {
+  return valid;
+}
+
+bool input_replayer::is_done() const {
+  return done && !has_next;
+}
+
+unsigned long input_replayer::get_count() const {
+  return count;
+}
+
+bool input_replayer::read(input_event_t& ev) {
+  if (!fetch()) {
+    return false;
+  }
+
+  uint64_t now = monotonic_ms();
+  if (!started) {
+    start = now;
+    started = true;
+  }
+  if (realtime && (now < start + next.time)) {
+    return false;
+  }
+
+  ev = next;
+  ev.time = now;
+  has_next = false;
+  ++count;
+  return true;
+}
+
+int input_replayer::next_timeout(uint64_t now) {
+  if (!fetch()) {
+    return -1;
+  }
+  if (!realtime || !started || (now >= start + next.time)) {
+    return 0;
+  }
+  return (int)std::min(start + next.time - now, (uint64_t)INT32_MAX);
+}
+
+key_decoder::key_decoder() :
+  deadline(0), keys_loaded(false), sgr_mouse(false),
+  motion(MOUSE_MOTION_NONE), mouse_mask(0), press_time(0) {
+
+  memset(&press, 0, sizeof(press));
+}
+
+void key_decoder::load_keys() {
+  /* Keys xterm reports with modifiers, kUP alone is Shift-Up */
+  static const struct {
+    const char* name;
+    int key;
+  } names[] = {
+    { "kUP", KEY_UP }, { "kDN", KEY_DOWN }, { "kLFT", KEY_LEFT },
+    { "kRIT", KEY_RIGHT }, { "kHOM", KEY_HOME }, { "kEND", KEY_END },
+    { "kIC", KEY_IC }, { "kDC", KEY_DC }, { "kPRV", KEY_PPAGE },
+    { "kNXT", KEY_NPAGE }
+  };
+
+  mod_keys.clear();
+  for (std::size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    /* The parameter of xterm is 1 plus the modifiers */
+    for (int param = 2; param <= 8; param++) {
+      std::string name = names[i].name;
+      if (param > 2) {
+        name += (char)('0' + param);
+      } else if ((names[i].key != KEY_UP) && (names[i].key != KEY_DOWN)) {
+        name += '2';
+      }
+
+      const char* str = tigetstr(name.c_str());
+      if ((str == NULL) || (str == (char*)-1)) {
+        continue;
+      }
+      int code = key_defined(str);
+      if (code <= KEY_MAX) {
+        continue;
+      }
+
+      int mods = param - 1;
+      mod_keys[code] = names[i].key | ((mods & 1) ? MOD_SHIFT : 0) |
+        ((mods & 2) ? MOD_ALT : 0) | ((mods & 4) ? MOD_CTRL : 0);
+    }
+  }
+  keys_loaded = true;
+}
+
+int key_decoder::translate(int key) {
+  if (key <= KEY_MAX) {
+    return key;
+  }
+  auto it = mod_keys.find(key);
+  return (it != mod_keys.end()) ? it->second : key;
+}
+
+/* Modes of xterm reporting motion */
+static const char* motion_on[] = { NULL, "\033[?1002h", "\033[?1003h" };
+static const char* motion_off[] = { NULL, "\033[?1002l", "\033[?1003l" };
+
+void key_decoder::enable_mouse(mmask_t mask, mouse_motion_t _motion) {
+  mouse_mask = mask;
+
+  /* ncurses does not ask xterm to report motion */
+  if (_motion != motion) {
+    if (motion != MOUSE_MOTION_NONE) {
+      putp(motion_off[motion]);
+    }
+    if (_motion != MOUSE_MOTION_NONE) {
+      putp(motion_on[_motion]);
+    }
+    motion = _motion;
+  }
+
+  /* ncurses decodes SGR reports itself if the terminal describes them */
+  const char* kmous = tigetstr("kmous");
+  if ((kmous != NULL) && (kmous != (char*)-1) &&
+      (strcmp(kmous, "\033[M") == 0) && !sgr_mouse) {
+    putp("\033[?1006h");
+    sgr_mouse = true;
+  }
+}
+
+void key_decoder::disable_mouse() {
+  if (motion != MOUSE_MOTION_NONE) {
+    putp(motion_off[motion]);
+    motion = MOUSE_MOTION_NONE;
+  }
+  if (sgr_mouse) {
+    putp("\033[?1006l");
+    sgr_mouse = false;
+  }
+}
+
+bool key_decoder::mouse_report(bool release, input_event_t& ev,
+    uint64_t now) {
+
+  int b, x, y;
+  if ((sscanf(seq.c_str() + 1, "%d;%d;%d", &b, &x, &y) != 3) ||
+      (x < 1) || (y < 1) || (b & 128)) {
+    return false;
+  }
+
+  MEVENT& m = ev.mouse;
+  memset(&m, 0, sizeof(m));
+  m.x = x - 1;
+  m.y = y - 1;
+
+  /* The low bits are the button, or the wheel with 64 */
+  int button = (b & 3) + 1 + ((b & 64) ? 3 : 0);
+  mmask_t state;
+  if (b & 32) {
+    state = REPORT_MOUSE_POSITION;
+  }
+  else if (button > 3) {
+    /* The wheel is not released */
+    if (release || (button > 5)) {
+      return false;
+    }
+    state = NCURSES_MOUSE_MASK(button, NCURSES_BUTTON_PRESSED);
+  }
+  else if (!release) {
+    state = NCURSES_MOUSE_MASK(button, NCURSES_BUTTON_PRESSED);
+    press = m;
+    press.bstate = state;
+    press_time = now;
+  }
+  else {
+    mmask_t pressed = NCURSES_MOUSE_MASK(button, NCURSES_BUTTON_PRESSED);
+    bool click = (press.bstate == pressed) &&
+      (now - press_time <= (uint64_t)mouseinterval(-1));
+    state = NCURSES_MOUSE_MASK(button,
+        (click) ? NCURSES_BUTTON_CLICKED : NCURSES_BUTTON_RELEASED);
+    press.bstate = 0;
+  }
+
+  if ((state & mouse_mask) == 0) {
+    return false;
+  }
+
+  m.bstate = state | ((b & 4) ? BUTTON_SHIFT : 0) |
+    ((b & 8) ? BUTTON_ALT : 0) | ((b & 16) ? BUTTON_CTRL : 0);
+  ev.key = KEY_MOUSE;
+  return true;
+}
+
+bool key_decoder::read(WINDOW* win, input_event_t& ev, uint64_t now) {
+  if (!keys_loaded) {
+    load_keys();
+  }
+
+  for (;;) {
+    int key = wgetch(win);
+    if (key == ERR) {
+      if (!seq.empty() && (now >= deadline)) {
+        seq.clear();
+      }
+      return false;
+    }
+
+    /* The parameters of an SGR mouse report, ended by M or m */
+    if (!seq.empty()) {
+      if ((((key >= '0') && (key <= '9')) || (key == ';')) &&
+          (seq.size() < 32)) {
+        seq += (char)key;
+        continue;
+      }
+      bool report = (key == 'M') || (key == 'm');
+      bool decoded = report && mouse_report((key == 'm'), ev, now);
+      seq.clear();
+      if (decoded) {
+        return true;
+      }
+      if (report) {
+        continue;
+      }
+    }
+
+    if (key != 27) {
+      ev.key = translate(key);
+      if ((ev.key == KEY_MOUSE) && (getmouse(&ev.mouse) != OK)) {
+        continue;
+      }
+      return true;
+    }
+
+    /* ncurses waited the escape delay for a keypad key, what follows the
+     * Escape arrived with it */
+    int next = wgetch(win);
+    if ((next == ERR) || (next == KEY_MOUSE) || (next == KEY_RESIZE)) {
+      if (next != ERR) {
+        ungetch(next);
+      }
+      ev.key = 27;
+      return true;
+    }
+
+    if ((next == '[') && sgr_mouse) {
+      int third = wgetch(win);
+      if (third == '<') {
+        seq = "<";
+        deadline = now + get_escdelay();
+        continue;
+      }
+      if (third != ERR) {
+        ungetch(third);
+      }
+    }
+    ev.key = translate(next) | MOD_ALT;
+    return true;
+  }
+}
+
+int key_decoder::next_timeout(uint64_t now) {
+  if (seq.empty()) {
+    return -1;
+  }
+  return (now >= deadline) ? 0 : (int)(deadline - now);
+}
@@ -0,0 +1,149 @@
+/*
+ * @file ncui_keymap.cc
+ * @author notweerdmonk
+ * @brief Compile bindings of keys into lookup tables.
+ */
+
+#include <ncui_keymap.h>
+
+using namespace ncui;
+
+const key_slot_t keymap::none = { ACTION_NONE, 0 };
+
+const key_slot_t keymap::modified = { ACTION_KEY, 0 };
+
+keymap::keymap(const keymap* _base) :
+  base(_base), version(0), base_version(0), compiled(false) {
+}
+
+int keymap::add_table() {
+  tables.resize(tables.size() + KEY_MAX + 1, none);
+  sparse.push_back(std::unordered_map<int, key_slot_t>());
+  return (int)sparse.size() - 1;
+}
+
+key_slot_t& keymap::slot(int table, int key) {
+  if ((key >= 0) && (key <= KEY_MAX)) {
+    return tables[((std::size_t)table * (KEY_MAX + 1)) + key];
+  }
+  std::unordered_map<int, key_slot_t>& map = sparse[table];
+  auto it = map.find(key);
+  if (it == map.end()) {
+    it = map.insert(std::make_pair(key, none)).first;
+  }
+  return it->second;
+}
+
+void keymap::apply(const binding_t& b) {
+  /* Keys before the last one lead to the table of the next key */
+  int table = 0;
+  for (std::size_t i = 0; i + 1 < b.keys.size(); i++) {
+    if (slot(table, b.keys[i]).action != ACTION_PREFIX) {
+      int next = add_table();
+      key_slot_t prefix = { ACTION_PREFIX, (uint16_t)next };
+      slot(table, b.keys[i]) = prefix;
+    }
+    table = slot(table, b.keys[i]).arg;
+  }
+
+  key_slot_t s = { (uint16_t)b.action, 0 };
+  if (b.action == ACTION_CALL) {
+    s.arg = (uint16_t)handlers.size();
+    handlers.push_back(b.handler);
+  }
+  slot(table, b.keys.back()) = s;
+}
+
+void keymap::compile_from(const keymap* k) {
+  if (k->base != NULL) {
+    compile_from(k->base);
+  } else {
+    for (int key = KEY_DOWN; key < KEY_MOUSE; key++) {
+      slot(0, key).action = ACTION_KEY;
+    }
+    for (int key = 32; key < 127; key++) {
+      slot(0, key).action = ACTION_INSERT;
+    }
+    slot(0, 27).action = ACTION_KEY;
+    slot(0, 10).action = ACTION_NEWLINE;
+    slot(0, KEY_BACKSPACE).action = ACTION_BACKSPACE;
+    slot(0, 127).action = ACTION_BACKSPACE;
+    slot(0, 8).action = ACTION_BACKSPACE;
+    slot(0, 9).action = ACTION_FOCUS_NEXT;
+    slot(0, KEY_BTAB).action = ACTION_FOCUS_PREV;
+    /* Ctrl-Z suspends the process in cbreak mode */
+    slot(0, 31).action = ACTION_UNDO;
+    slot(0, 18).action = ACTION_REDO;
+  }
+
+  for (std::size_t i = 0; i < k->bindings.size(); i++) {
+    apply(k->bindings[i]);
+  }
+}
+
+void keymap::compile() {
+  tables.clear();
+  sparse.clear();
+  handlers.clear();
+  add_table();
+  compile_from(this);
+  base_version = (base != NULL) ? base->stamp() : 0;
+  compiled = true;
+}
+
+void keymap::add(const std::vector<int>& keys, key_action_t action,
+    const key_handler_t& handler) {
+
+  if (keys.empty() || (action == ACTION_PREFIX)) {
+    return;
+  }
+  unbind(keys);
+
+  binding_t b;
+  b.keys = keys;
+  b.action = action;
+  b.handler = handler;
+  bindings.push_back(b);
+  ++version;
+  compiled = false;
+}
+
+void keymap::bind(int key, key_action_t action) {
+  add(std::vector<int>(1, key), action, key_handler_t());
+}
+
+void keymap::bind(int key, const key_handler_t& handler) {
+  add(std::vector<int>(1, key), ACTION_CALL, handler);
+}
+
+void keymap::bind(const std::vector<int>& keys, key_action_t action) {
+  add(keys, action, key_handler_t());
+}
+
+void keymap::bind(const std::vector<int>& keys,
+    const key_handler_t& handler) {
+  add(keys, ACTION_CALL, handler);
+}
+
+void keymap::unbind(const std::vector<int>& keys) {
+  for (std::size_t i = 0; i < bindings.size(); i++) {
+    if (bindings[i].keys == keys) {
+      bindings.erase(bindings.begin() + i);
+      ++version;
+      compiled = false;
+      return;
+    }
+  }
+}
+
+const key_slot_t& keymap::lookup_sparse(int table, int key) const {
+  if ((std::size_t)table >= sparse.size()) {
+    return none;
+  }
+  auto it = sparse[table].find(key);
+  if (it != sparse[table].end()) {
+    return it->second;
+  }
+  /* Keys with modifiers are dispatched unless they are bound */
+  return ((table == 0) && (key_mods(key) != 0)) ? modified : none;
+}
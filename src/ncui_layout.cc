@@ -0,0 +1,55 @@
+/*
+ * @file ncui_layout.cc
+ * @author notweerdmonk
+ * @brief Distribute space among windows.
+ */
+
+#include <ncui_layout.h>
+
+using namespace ncui;
+
+void ncui::layout_distribute(
+    const size_spec_t* specs,
+    int n,
+    int avail,
+    int* sizes
+  ) {
+
+  int used = 0;
+  int weights = 0;
+
+  for (int i = 0; i < n; i++) {
+    if (specs[i].unit == SIZE_FLEX) {
+      weights += (specs[i].value > 0) ? specs[i].value : 0;
+      sizes[i] = 0;
+    } else {
+      sizes[i] = specs[i].resolve(avail);
+      used += sizes[i];
+    }
+  }
+
+  int left = avail - used;
+  if (left < 0) {
+    left = 0;
+  }
+
+  /* Share the space left over by weight, the last flexible child takes the
+   * remainder of the division */
+  int shared = 0;
+  int last = -1;
+  for (int i = 0; i < n; i++) {
+    if ((specs[i].unit == SIZE_FLEX) && (weights > 0) &&
+        (specs[i].value > 0)) {
+      int share = (left * specs[i].value) / weights;
+      sizes[i] = specs[i].clamp(share);
+      shared += sizes[i];
+      last = i;
+    } else if (specs[i].unit == SIZE_FLEX) {
+      sizes[i] = specs[i].clamp(0);
+    }
+  }
+
+  if ((last > -1) && (shared < left)) {
+    sizes[last] = specs[last].clamp(sizes[last] + (left - shared));
+  }
+}
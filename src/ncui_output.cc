@@ -0,0 +1,257 @@
+/*
+ * @file ncui_output.cc
+ * @author notweerdmonk
+ * @brief Pump the output of ncurses to terminals.
+ */
+
+#include <ncui_output.h>
+#include <ncui_timer.h>
+
+using namespace ncui;
+
+output_pump::output_pump() {
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if ((epoll_fd == -1) || (wake_fd == -1)) {
+    throw std::runtime_error("output_pump: creation failed!");
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+
+  std::thread(&output_pump::run, this).detach();
+}
+
+output_pump& output_pump::get_instance() {
+  /* Never destroyed, the thread runs until the process exits */
+  static output_pump* instance = new output_pump();
+  return *instance;
+}
+
+void output_pump::wake() {
+  uint64_t one = 1;
+  ssize_t ret = write(wake_fd, &one, sizeof(one));
+  (void)ret;
+}
+
+void output_pump::drain(term_output_t* out) {
+  char chunk[4096];
+  for (;;) {
+    ssize_t len = read(out->pipe_fd, chunk, sizeof(chunk));
+    if (len > 0) {
+      /* Bytes of a terminal that failed are dropped */
+      if (!out->failed) {
+        out->buf.append(chunk, len);
+      }
+    } else if ((len == -1) && (errno == EINTR)) {
+      continue;
+    } else {
+      break;
+    }
+  }
+}
+
+void output_pump::arm(term_output_t* out, bool armed) {
+  if ((out->out_armed == armed) || out->failed) {
+    return;
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = (armed) ? (uint32_t)EPOLLOUT : 0u;
+  ev.data.ptr = &out->wr;
+  epoll_ctl(epoll_fd, EPOLL_CTL_MOD, out->tty_fd, &ev);
+  out->out_armed = armed;
+}
+
+void output_pump::flush(term_output_t* out) {
+  while (out->off < out->buf.size()) {
+    ssize_t len = write(out->tty_fd, out->buf.data() + out->off,
+        out->buf.size() - out->off);
+    if (len > 0) {
+      out->off += len;
+    } else if ((len == -1) && (errno == EINTR)) {
+      continue;
+    } else if ((len == -1) && (errno == EAGAIN)) {
+      /* Resumed when the terminal can take more */
+      arm(out, true);
+      break;
+    } else {
+      hang_up(out);
+      break;
+    }
+  }
+
+  if (out->off == out->buf.size()) {
+    out->buf.clear();
+    out->off = 0;
+    arm(out, false);
+  } else if (out->off >= 65536) {
+    out->buf.erase(0, out->off);
+    out->off = 0;
+  }
+}
+
+void output_pump::hang_up(term_output_t* out) {
+  /* Hang ups and errors are reported even when the terminal is not watched
+   * for writing, and again until it is no longer in the set */
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, out->tty_fd, NULL);
+  out->out_armed = false;
+  out->failed = true;
+  out->buf.clear();
+  out->off = 0;
+}
+
+void output_pump::remove(term_output_t* out) {
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, out->pipe_fd, NULL);
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, out->tty_fd, NULL);
+  outputs.erase(
+      std::remove(outputs.begin(), outputs.end(), out),
+      outputs.end()
+    );
+}
+
+void output_pump::run() {
+  struct epoll_event events[16];
+  int timeout = -1;
+
+  for (;;) {
+    int count = epoll_wait(epoll_fd, events, 16, timeout);
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (int i = 0; i < count; i++) {
+      endpoint_t* ep = (endpoint_t*)events[i].data.ptr;
+      if (ep == NULL) {
+        uint64_t val;
+        ssize_t ret = read(wake_fd, &val, sizeof(val));
+        (void)ret;
+        continue;
+      }
+
+      /* Outputs are only removed by this thread, after the batch */
+      if (ep->tty && (events[i].events & (EPOLLHUP | EPOLLERR))) {
+        hang_up(ep->out);
+        continue;
+      }
+      if (!ep->tty) {
+        drain(ep->out);
+      }
+      flush(ep->out);
+    }
+
+    /* Closed outputs are flushed before they are removed, unless the terminal
+     * does not take them in time */
+    timeout = -1;
+    uint64_t now = monotonic_ms();
+    for (std::size_t i = outputs.size(); i > 0; i--) {
+      term_output_t* out = outputs[i - 1];
+      if (!out->closing) {
+        continue;
+      }
+
+      drain(out);
+      flush(out);
+
+      if (out->buf.empty() || out->failed || (now >= out->deadline)) {
+        remove(out);
+        out->done = true;
+        cond.notify_all();
+      } else {
+        int left = (int)(out->deadline - now);
+        if ((timeout < 0) || (left < timeout)) {
+          timeout = left;
+        }
+      }
+    }
+  }
+}
+
+FILE* output_pump::open(int tty_fd) {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) == -1) {
+    return NULL;
+  }
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+  /* A description of its own, so input is not made non-blocking */
+  int fd = -1;
+  const char* name = ttyname(tty_fd);
+  if (name != NULL) {
+    fd = ::open(name, O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+  }
+  if (fd == -1) {
+    fd = fcntl(tty_fd, F_DUPFD_CLOEXEC, 0);
+    if (fd != -1) {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+  }
+
+  FILE* fp = (fd != -1) ? fdopen(fds[1], "w") : NULL;
+  if (fp == NULL) {
+    if (fd != -1) {
+      ::close(fd);
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return NULL;
+  }
+
+  term_output_t* out = new term_output_t;
+  out->fp = fp;
+  out->pipe_fd = fds[0];
+  out->tty_fd = fd;
+  out->off = 0;
+  out->out_armed = false;
+  out->failed = false;
+  out->closing = false;
+  out->done = false;
+  out->deadline = 0;
+  out->rd.out = out;
+  out->rd.tty = false;
+  out->wr.out = out;
+  out->wr.tty = true;
+
+  std::lock_guard<std::mutex> guard(lock);
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = &out->rd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, out->pipe_fd, &ev);
+
+  ev.events = 0;
+  ev.data.ptr = &out->wr;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, out->tty_fd, &ev);
+
+  outputs.push_back(out);
+  return fp;
+}
+
+void output_pump::close(FILE* fp, int timeout) {
+  fflush(fp);
+
+  std::unique_lock<std::mutex> guard(lock);
+
+  auto it = std::find_if(outputs.begin(), outputs.end(),
+      [fp](term_output_t* out) { return out->fp == fp; });
+  if (it == outputs.end()) {
+    return;
+  }
+
+  term_output_t* out = *it;
+  out->closing = true;
+  out->deadline = monotonic_ms() + timeout;
+  wake();
+
+  while (!out->done) {
+    cond.wait(guard);
+  }
+
+  ::close(out->pipe_fd);
+  ::close(out->tty_fd);
+  delete out;
+}
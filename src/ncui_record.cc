@@ -0,0 +1,354 @@
+/*
+ * @file ncui_record.cc
+ * @author notweerdmonk
+ * @brief Record the frames drawn to a terminal and read them back.
+ */
+
+#include <ncui_record.h>
+#include <ncui_timer.h>
+
+using namespace ncui;
+
+using detail::put_varint;
+using detail::get_varint;
+
+static const char rec_magic[] = "NCUIREC";
+
+static const int rec_version = 1;
+
+/* Unchanged cells between two changes that are cheaper to repeat than to
+ * start another span for */
+static const int span_gap = 4;
+
+void detail::put_varint(std::string& buf, uint64_t val) {
+  while (val >= 0x80) {
+    buf += (char)((val & 0x7f) | 0x80);
+    val >>= 7;
+  }
+  buf += (char)val;
+}
+
+bool detail::get_varint(FILE* fp, uint64_t& val) {
+  val = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = fgetc(fp);
+    if (c == EOF) {
+      return false;
+    }
+    val |= (uint64_t)(c & 0x7f) << shift;
+    if ((c & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+frame_recorder::frame_recorder(FILE* _fp) :
+  fp(_fp), last(monotonic_ms()), lines(0), cols(0), full(true), written(0) {
+
+  buf.append(rec_magic, sizeof(rec_magic) - 1);
+  buf += (char)rec_version;
+  resize();
+
+  fwrite(buf.data(), 1, buf.size(), fp);
+  written += buf.size();
+}
+
+frame_recorder::~frame_recorder() {
+  fflush(fp);
+}
+
+void frame_recorder::resize() {
+  lines = LINES;
+  cols = COLS;
+  shadow.assign((std::size_t)lines * cols, 0);
+  lo.assign(lines, cols);
+  hi.assign(lines, 0);
+  full = true;
+
+  buf += (char)REC_SIZE;
+  put_varint(buf, lines);
+  put_varint(buf, cols);
+}
+
+void frame_recorder::damage(WINDOW* win) {
+  int y, x, h, w;
+  getbegyx(win, y, x);
+  getmaxyx(win, h, w);
+
+  int y_end = std::min(y + h, lines);
+  int x_end = std::min(x + w, cols);
+  for (int i = std::max(y, 0); i < y_end; i++) {
+    lo[i] = std::min(lo[i], std::max(x, 0));
+    hi[i] = std::max(hi[i], x_end);
+  }
+}
+
+void frame_recorder::damage_all() {
+  full = true;
+}
+
+void frame_recorder::recolor(const std::vector<short>& changed) {
+  bool any = false;
+  for (std::size_t i = 0; i < changed.size(); i++) {
+    short pair = changed[i];
+    if (((std::size_t)pair < pairs_seen.size()) && pairs_seen[pair]) {
+      pairs_seen[pair] = false;
+      any = true;
+    }
+  }
+  if (!any) {
+    return;
+  }
+
+  /* A cell is only recorded with a pair once the pair has been seen */
+  for (int y = 0; y < lines; y++) {
+    chtype* sh = shadow.data() + ((std::size_t)y * cols);
+    for (int x = 0; x < cols; x++) {
+      short pair = PAIR_NUMBER(sh[x]);
+      if ((pair != 0) && !pairs_seen[pair]) {
+        sh[x] = 0;
+        lo[y] = std::min(lo[y], x);
+        hi[y] = std::max(hi[y], x + 1);
+      }
+    }
+  }
+}
+
+void frame_recorder::note_pairs(const chtype* cells, int len) {
+  for (int i = 0; i < len; i++) {
+    short pair = PAIR_NUMBER(cells[i]);
+    if (pair == 0) {
+      continue;
+    }
+    if ((std::size_t)pair >= pairs_seen.size()) {
+      pairs_seen.resize(pair + 1, false);
+    }
+    if (pairs_seen[pair]) {
+      continue;
+    }
+    pairs_seen[pair] = true;
+
+    short fg = -1;
+    short bg = -1;
+    pair_content(pair, &fg, &bg);
+
+    /* Default colors are -1 */
+    buf += (char)REC_PAIR;
+    put_varint(buf, pair);
+    put_varint(buf, fg + 1);
+    put_varint(buf, bg + 1);
+  }
+}
+
+int frame_recorder::encode_row(int y, int& prev_y) {
+  int x0 = lo[y];
+  int x1 = std::min(hi[y], cols);
+  int n = x1 - x0;
+  if (n <= 0) {
+    return 0;
+  }
+
+  /* curscr holds what is on the terminal, its cursor is the one of the
+   * terminal and must not move */
+  int cur_y, cur_x;
+  getyx(curscr, cur_y, cur_x);
+  row.resize(n + 1);
+  mvwinchnstr(curscr, y, x0, row.data(), n);
+  wmove(curscr, cur_y, cur_x);
+
+  chtype* sh = shadow.data() + ((std::size_t)y * cols);
+  const chtype* cells = row.data() - x0;
+  int count = 0;
+
+  int x = x0;
+  while (x < x1) {
+    while ((x < x1) && (cells[x] == sh[x])) {
+      ++x;
+    }
+    if (x == x1) {
+      break;
+    }
+
+    int start = x;
+    int end = x + 1;
+    for (int i = x + 1, same = 0; i < x1; i++) {
+      if (cells[i] != sh[i]) {
+        end = i + 1;
+        same = 0;
+      } else if (++same >= span_gap) {
+        break;
+      }
+    }
+
+    put_varint(spans, y - prev_y);
+    put_varint(spans, start);
+    put_varint(spans, end - start);
+    prev_y = y;
+
+    chtype prev = 0;
+    for (int i = start; i < end; ) {
+      int j = i + 1;
+      while ((j < end) && (cells[j] == cells[i])) {
+        ++j;
+      }
+      put_varint(spans, j - i);
+      put_varint(spans, cells[i] ^ prev);
+      note_pairs(&cells[i], 1);
+      prev = cells[i];
+      i = j;
+    }
+
+    std::copy(&cells[start], &cells[end], &sh[start]);
+    ++count;
+    x = end;
+  }
+
+  return count;
+}
+
+void frame_recorder::frame() {
+  buf.clear();
+  spans.clear();
+
+  if ((LINES != lines) || (COLS != cols)) {
+    resize();
+  }
+  if (full) {
+    std::fill(lo.begin(), lo.end(), 0);
+    std::fill(hi.begin(), hi.end(), cols);
+    full = false;
+  }
+
+  int count = 0;
+  int prev_y = 0;
+  for (int y = 0; y < lines; y++) {
+    if (lo[y] < hi[y]) {
+      count += encode_row(y, prev_y);
+      lo[y] = cols;
+      hi[y] = 0;
+    }
+  }
+
+  if (count > 0) {
+    uint64_t now = monotonic_ms();
+    buf += (char)REC_FRAME;
+    put_varint(buf, now - last);
+    put_varint(buf, count);
+    buf += spans;
+    last = now;
+  }
+
+  if (!buf.empty()) {
+    fwrite(buf.data(), 1, buf.size(), fp);
+    written += buf.size();
+  }
+}
+
+std::size_t frame_recorder::bytes() const {
+  return written;
+}
+
+frame_reader::frame_reader(FILE* _fp) :
+  fp(_fp), time(0), lines(0), cols(0), valid(false), malformed(false) {
+
+  char magic[sizeof(rec_magic)];
+  if (fread(magic, 1, sizeof(magic), fp) == sizeof(magic)) {
+    valid = (memcmp(magic, rec_magic, sizeof(rec_magic) - 1) == 0) &&
+      (magic[sizeof(rec_magic) - 1] == rec_version);
+  }
+}
+
+bool frame_reader::is_valid() const {
+  return valid;
+}
+
+bool frame_reader::is_malformed() const {
+  return malformed;
+}
+
+bool frame_reader::next(rec_record_t& rec) {
+  if (!valid || malformed) {
+    return false;
+  }
+
+  int kind = fgetc(fp);
+  uint64_t a, b, c;
+
+  switch (kind) {
+    case EOF:
+      /* The end of the recording, between records */
+      return false;
+
+    case REC_SIZE:
+      /* Terminals larger than what ncurses allows are not recorded */
+      if (!get_varint(fp, a) || !get_varint(fp, b) ||
+          (a > INT16_MAX) || (b > INT16_MAX)) {
+        break;
+      }
+      rec.kind = REC_SIZE;
+      rec.lines = lines = (int)a;
+      rec.cols = cols = (int)b;
+      return true;
+
+    case REC_PAIR:
+      if (!get_varint(fp, a) || !get_varint(fp, b) ||
+          !get_varint(fp, c)) {
+        break;
+      }
+      rec.kind = REC_PAIR;
+      rec.pair = (short)a;
+      rec.fg = (short)b - 1;
+      rec.bg = (short)c - 1;
+      return true;
+
+    case REC_FRAME: {
+      uint64_t count;
+      if (!get_varint(fp, a) || !get_varint(fp, count)) {
+        break;
+      }
+      time += a;
+      rec.kind = REC_FRAME;
+      rec.time = time;
+      rec.spans.clear();
+      rec.cells.clear();
+
+      int y = 0;
+      for (uint64_t i = 0; i < count; i++) {
+        /* Spans are within the terminal, so that a corrupt length cannot
+         * make a huge allocation */
+        uint64_t dy, x, len;
+        if (!get_varint(fp, dy) || !get_varint(fp, x) ||
+            !get_varint(fp, len) || (dy >= (uint64_t)(lines - y)) ||
+            (x >= (uint64_t)cols) || (len > (uint64_t)cols - x)) {
+          malformed = true;
+          return false;
+        }
+        y += (int)dy;
+
+        rec_span_t span = { y, (int)x, (int)len, rec.cells.size() };
+        rec.spans.push_back(span);
+
+        chtype prev = 0;
+        for (uint64_t left = len; left > 0; ) {
+          uint64_t run, val;
+          if (!get_varint(fp, run) || !get_varint(fp, val) ||
+              (run == 0) || (run > left)) {
+            malformed = true;
+            return false;
+          }
+          prev ^= (chtype)val;
+          rec.cells.insert(rec.cells.end(), run, prev);
+          left -= run;
+        }
+      }
+      return true;
+    }
+
+    default:
+      break;
+  }
+
+  malformed = true;
+  return false;
+}
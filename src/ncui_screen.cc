@@ -6,31 +6,438 @@
 
 #include <ncui_screen.h>
 #include <ncui_window.h>
+#include <ncui_timer.h>
+#include <ncui_output.h>
+#include <ncui_record.h>
 
 using namespace ncui;
 
+Screen* Screen::current = NULL;
+
+std::vector<Screen*> Screen::screens;
+
+/* The current terminal of ncurses is shared by all threads */
+static std::recursive_mutex ncurses_lock;
+
+/* delscreen also deletes windows of the other terminals, so terminals are
+ * freed once no screen is left, along with the streams ncurses wrote to */
+static std::vector<std::pair<SCREEN*, FILE*> > released_terms;
+
+/* Milliseconds ncurses waits for the rest of an escape sequence */
+static const int default_escdelay = 25;
+
+/* Events read ahead at most while coalescing mouse motion */
+static const std::size_t max_read_ahead = 256;
+
 class Screen::ScreenImpl {
-  bool                    exit_cond;
+  std::atomic<bool>       exit_cond;
+
+  SCREEN*                 term;
+
+  /* Stream ncurses writes to, a pipe to the output pump if buffered */
+  FILE*                   term_out;
+  int                     tty_fd;
+  bool                    buffered;
+  struct termios          saved_modes;
 
   scr_cb_t                update_cb;
   scr_cb_data_t           update_cb_data;
 
+  int                     epoll_fd;
+  int                     input_fd;
+  bool                    input_watched;
+  bool                    input_pending;
+
+  timer_wheel_t           timers;
+
+  typedef struct {
+    int                   events;
+    fd_cb_t               cb;
+    fd_cb_data_t          cb_data;
+    uint32_t              gen;
+  } fd_watch_t;
+
+  /* Watched file descriptors, the generation in the epoll data tells events
+   * of a descriptor apart from those of an earlier watch of the same number */
+  std::unordered_map<int, fd_watch_t> watches;
+  uint32_t                watch_gen;
+
+  /* Calls deferred to the next iteration of the event loop */
+  std::vector<std::pair<scr_cb_t, scr_cb_data_t> > posted;
+  std::vector<std::pair<scr_cb_t, scr_cb_data_t> > running;
+  std::mutex              posted_lock;
+
+  /* Wakes up the event loop from other threads */
+  int                     wake_fd;
+
+  struct epoll_event      events[16];
+
+  std::thread             render_thread;
+
+  /* Records the frames drawn, if recording */
+  std::unique_ptr<frame_recorder_t> recorder;
+
+  /* Replaces the terminal as the source of input events, if set */
+  input_source*           source;
+
+  /* Records the input events read, if recording */
+  std::unique_ptr<input_recorder_t> input_rec;
+
+  /* Color pairs are per terminal */
+  style_cache_t           styles;
+
+  /* Pairs recycled in the current frame, reported to the recorder */
+  std::vector<short>      recycled_pairs;
+
+  /* Decodes keys and mouse reports ncurses reads from the terminal */
+  key_decoder_t           decoder;
+
+  /* Input read ahead while coalescing mouse motion, with the window under
+   * each motion, and the next one to be dispatched */
+  std::vector<input_event_t> queued;
+  std::vector<Window*>    queued_targets;
+  std::size_t             queued_next;
+
+  /* Bindings of keys shared by the windows */
+  keymap_t                keys;
+
+  static uint32_t to_epoll(int events) {
+    uint32_t ep = 0;
+    if (events & FD_EV_READ) {
+      ep |= EPOLLIN;
+    }
+    if (events & FD_EV_WRITE) {
+      ep |= EPOLLOUT;
+    }
+    return ep;
+  }
+
+  static int from_epoll(uint32_t ep) {
+    int events = 0;
+    if (ep & EPOLLIN) {
+      events |= FD_EV_READ;
+    }
+    if (ep & EPOLLOUT) {
+      events |= FD_EV_WRITE;
+    }
+    if (ep & (EPOLLHUP | EPOLLRDHUP)) {
+      events |= FD_EV_HUP;
+    }
+    if (ep & EPOLLERR) {
+      events |= FD_EV_ERROR;
+    }
+    return events;
+  }
+
   public:
 
-  ScreenImpl() {
-    
-    void *status = initscr();
-    if (status == NULL) {
+  ScreenImpl(const char* type, FILE* out, FILE* in, bool _buffered) :
+    exit_cond(false), term_out(out), tty_fd(fileno(out)), buffered(false),
+    update_cb(NULL), update_cb_data(NULL), input_fd(fileno(in)),
+    input_watched(false), input_pending(false), timers(monotonic_ms()),
+    watch_gen(0), source(NULL), queued_next(0) {
+
+    /* Created before the terminal is touched, so a failure leaves it as it
+     * was */
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if ((epoll_fd == -1) || (wake_fd == -1)) {
+      if (epoll_fd != -1) {
+        close(epoll_fd);
+      }
+      if (wake_fd != -1) {
+        close(wake_fd);
+      }
+      throw std::runtime_error("Screen: epoll_create1 failed!");
+    }
+
+    if (_buffered && (tcgetattr(input_fd, &saved_modes) == 0)) {
+      term_out = output_pump::get_instance().open(fileno(out));
+      buffered = (term_out != NULL);
+      if (!buffered) {
+        term_out = out;
+      }
+    }
+
+    /* The terminal becomes the current one */
+    term = newterm(type, term_out, in);
+    if (term == NULL) {
+      if (buffered) {
+        output_pump::get_instance().close(term_out, 0);
+        fclose(term_out);
+      }
+      close(wake_fd);
+      close(epoll_fd);
       throw std::runtime_error("Screen: creation failed!");
     }
     else {
       curs_set(0);
       cbreak();
       noecho();
+
+      /* The Escape key is not held up unless the environment asks for it */
+      if (getenv("ESCDELAY") == NULL) {
+        set_escdelay(default_escdelay);
+      }
     }
+
+    /* ncurses sets the modes and gets the size of the terminal through its
+     * output, which is a pipe */
+    if (buffered) {
+      struct termios modes = saved_modes;
+      modes.c_lflag &= ~(ICANON | ECHO);
+      modes.c_cc[VMIN] = 1;
+      modes.c_cc[VTIME] = 0;
+      tcsetattr(input_fd, TCSADRAIN, &modes);
+
+      sync_size();
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.data.u64 = input_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, input_fd, &ev);
+
+    ev.events = EPOLLIN;
+    ev.data.u64 = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
   }
 
   ~ScreenImpl() {
+    close(wake_fd);
+    close(epoll_fd);
+  }
+
+  /**
+   * @brief Resize ncurses to the size of the terminal if buffered. ncurses
+   * asks its output for the size, which is a pipe, so after SIGWINCH it
+   * reports KEY_RESIZE without the new size.
+   */
+  void sync_size() {
+    struct winsize size;
+    if (buffered && (ioctl(tty_fd, TIOCGWINSZ, &size) == 0) &&
+        (size.ws_row > 0) && (size.ws_col > 0)) {
+      resizeterm(size.ws_row, size.ws_col);
+    }
+  }
+
+  void wake() {
+    uint64_t one = 1;
+    ssize_t ret = write(wake_fd, &one, sizeof(one));
+    (void)ret;
+  }
+
+  bool is_started() {
+    return render_thread.joinable();
+  }
+
+  bool start(Screen* scr) {
+    if (render_thread.joinable()) {
+      return false;
+    }
+    try {
+      render_thread = std::thread(&Screen::mainloop, scr);
+    }
+    catch(std::exception& e) {
+      return false;
+    }
+    return true;
+  }
+
+  void join() {
+    if (render_thread.joinable() &&
+        (render_thread.get_id() != std::this_thread::get_id())) {
+      render_thread.join();
+    }
+  }
+
+  SCREEN* get_term() {
+    return term;
+  }
+
+  int get_epoll_fd() {
+    return epoll_fd;
+  }
+
+  void release_term() {
+    if (buffered) {
+      output_pump::get_instance().close(term_out, 1000);
+      tcsetattr(input_fd, TCSADRAIN, &saved_modes);
+    }
+    released_terms.push_back(
+        std::make_pair(term, (buffered) ? term_out : (FILE*)NULL));
+    term = NULL;
+  }
+
+  timer_id_t add_timer(unsigned long ms, timer_cb_t cb,
+      timer_cb_data_t cb_data, bool periodic) {
+    return timers.add(monotonic_ms() + ms, (periodic) ? ms : 0, cb, cb_data);
+  }
+
+  bool cancel_timer(timer_id_t id) {
+    return timers.cancel(id);
+  }
+
+  void run_timers() {
+    timers.advance(monotonic_ms());
+  }
+
+  bool watch_fd(int fd, int events, fd_cb_t cb, fd_cb_data_t cb_data) {
+    if ((fd < 0) || (fd == input_fd) || (cb == NULL)) {
+      return false;
+    }
+
+    auto it = watches.find(fd);
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = to_epoll(events) | EPOLLRDHUP;
+    uint32_t gen = (it != watches.end()) ? it->second.gen : ++watch_gen;
+    ev.data.u64 = ((uint64_t)gen << 32) | (uint32_t)fd;
+
+    int op = (it != watches.end()) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(epoll_fd, op, fd, &ev) == -1) {
+      return false;
+    }
+
+    fd_watch_t& watch = watches[fd];
+    watch.events = events;
+    watch.cb = cb;
+    watch.cb_data = cb_data;
+    watch.gen = gen;
+    return true;
+  }
+
+  bool unwatch_fd(int fd) {
+    auto it = watches.find(fd);
+    if (it == watches.end()) {
+      return false;
+    }
+
+    /* The descriptor may have been closed already, which removed it */
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    watches.erase(it);
+    return true;
+  }
+
+  void post(scr_cb_t cb, scr_cb_data_t cb_data) {
+    std::lock_guard<std::mutex> guard(posted_lock);
+    if (posted.empty()) {
+      wake();
+    }
+    posted.push_back(std::make_pair(cb, cb_data));
+  }
+
+  void run_posted() {
+    /* Calls posted by these calls run in the next iteration */
+    {
+      std::lock_guard<std::mutex> guard(posted_lock);
+      running.swap(posted);
+    }
+    for (std::size_t i = 0; i < running.size(); i++) {
+      running[i].first(running[i].second);
+    }
+    running.clear();
+  }
+
+  void note_input() {
+    input_pending = true;
+  }
+
+  /**
+   * @brief Get ready to wait for events.
+   * @param read_input Whether a window reads terminal input. If not, the
+   * terminal is not watched to avoid waking up for input nobody consumes.
+   * @return The time until the next timer is due in milliseconds, 0 if there
+   * is work left and -1 if there are no timers.
+   */
+  int prepare(bool read_input) {
+    int timeout = timers.next_timeout(monotonic_ms());
+
+    /* ncurses may hold input it has already read from the terminal */
+    if (input_pending) {
+      input_pending = false;
+      timeout = 0;
+    }
+
+    /* An incomplete mouse report is dropped after the escape delay */
+    int pending = decoder.next_timeout(monotonic_ms());
+    if ((pending >= 0) && ((timeout < 0) || (pending < timeout))) {
+      timeout = pending;
+    }
+
+    /* The terminal is not read while another source replaces it */
+    if (read_input && (source != NULL)) {
+      int next = source->next_timeout(monotonic_ms());
+      if ((next >= 0) && ((timeout < 0) || (next < timeout))) {
+        timeout = next;
+      }
+      read_input = false;
+    }
+
+    if (read_input != input_watched) {
+      struct epoll_event ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.events = (read_input) ? (uint32_t)EPOLLIN : 0u;
+      ev.data.u64 = input_fd;
+      epoll_ctl(epoll_fd, EPOLL_CTL_MOD, input_fd, &ev);
+      input_watched = read_input;
+    }
+
+    return timeout;
+  }
+
+  /**
+   * @brief Wait for terminal input, a watched file descriptor or a wake up.
+   * Posted calls wake up the loop. Does not touch ncurses.
+   * @param timeout The timeout in milliseconds, -1 to block.
+   * @return The number of ready file descriptors.
+   */
+  int wait_events(int timeout) {
+    /* Interrupted by signals such as SIGWINCH, which ncurses turns into
+     * KEY_RESIZE */
+    int count = epoll_wait(epoll_fd, events, 16, timeout);
+    return (count < 0) ? 0 : count;
+  }
+
+  /**
+   * @brief Call the callbacks of the file descriptors that are ready.
+   * @param count The number returned by wait_events.
+   */
+  void dispatch_events(int count) {
+    for (int i = 0; i < count; i++) {
+      int fd = (int)(uint32_t)events[i].data.u64;
+      uint32_t gen = (uint32_t)(events[i].data.u64 >> 32);
+      if (fd == wake_fd) {
+        uint64_t val;
+        ssize_t ret = read(wake_fd, &val, sizeof(val));
+        (void)ret;
+        continue;
+      }
+      if (gen == 0) {
+        continue;
+      }
+
+      /* An earlier callback may have unwatched or replaced the watch */
+      auto it = watches.find(fd);
+      if ((it == watches.end()) || (it->second.gen != gen)) {
+        continue;
+      }
+
+      int ready = from_epoll(events[i].events) &
+        (it->second.events | FD_EV_HUP | FD_EV_ERROR);
+      if (ready != 0) {
+        it->second.cb(fd, ready, it->second.cb_data);
+      }
+    }
+  }
+
+  /**
+   * @brief Wait for events without blocking, then call the callbacks of the
+   * ready file descriptors.
+   */
+  void poll() {
+    dispatch_events(wait_events(0));
   }
 
   int set_cursor(int visibility) {
@@ -45,10 +452,36 @@ class Screen::ScreenImpl {
 
   void enable_color() {
     start_color();
+    styles.reset();
+  }
+
+  style_id_t add_style(const style_t& style) {
+    return styles.add(style);
+  }
+
+  keymap_t& get_keymap() {
+    return keys;
+  }
+
+  bool resolve_style(style_id_t id, attr_t& attrs, short& pair, bool pin) {
+    return styles.resolve(id, attrs, pair, pin);
+  }
+
+  void unpin_style(style_id_t id) {
+    styles.unpin(id);
+  }
+
+  void enable_mouse_events(mouse_motion_t motion) {
+    mmask_t mask = ALL_MOUSE_EVENTS;
+    if (motion != MOUSE_MOTION_NONE) {
+      mask |= REPORT_MOUSE_POSITION;
+    }
+    mousemask(mask, NULL);
+    decoder.enable_mouse(mask, motion);
   }
 
-  void enable_mouse_events() {
-    mousemask(ALL_MOUSE_EVENTS, NULL);
+  void disable_mouse_events() {
+    decoder.disable_mouse();
   }
 
   void exit_screen() {
@@ -61,50 +494,294 @@ class Screen::ScreenImpl {
 
   void print(int y, int x, std::string& str) {
     mvprintw(y, x, "%s", str.c_str());
+    damage_all();
   }
 
   void refresh() {
     ::refresh();
+    damage_all();
   }
 
   void clear() {
     ::clear();
+    damage_all();
   }
 
   void update() {
     if (update_cb) {
       update_cb(update_cb_data);
+      damage_all();
+    }
+  }
+
+  void set_input_source(input_source* src) {
+    source = src;
+  }
+
+  bool start_recording_input(FILE* fp) {
+    if (input_rec || (fp == NULL)) {
+      return false;
+    }
+    input_rec.reset(new input_recorder_t(fp));
+    return true;
+  }
+
+  void stop_recording_input() {
+    input_rec.reset();
+  }
+
+  bool read_input(WINDOW* win, input_event_t& ev) {
+    if (source != NULL) {
+      if (!source->read(ev)) {
+        return false;
+      }
+    } else {
+      ev.time = monotonic_ms();
+      if (!decoder.read(win, ev, ev.time)) {
+        return false;
+      }
+      if (ev.key == KEY_RESIZE) {
+        sync_size();
+      }
+      /* ncurses may have buffered more input */
+      note_input();
+    }
+
+    if (input_rec) {
+      input_rec->record(ev);
+    }
+    return true;
+  }
+
+  bool next_queued(input_event_t& ev) {
+    if (queued_next < queued.size()) {
+      ev = queued[queued_next++];
+      /* Windows changed by the event are drawn with the next frame */
+      note_input();
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Read the input available after a motion of the mouse, keeping
+   * the latest motion over each window. Motion is not coalesced across
+   * other events, which are all kept in order.
+   * @param scr The screen, to find the windows under the mouse.
+   * @param win The window reading the input.
+   * @param[in,out] ev The motion read, replaced with the first event to
+   * dispatch. The others are dispatched with the next frames.
+   */
+  void coalesce_motion(Screen* scr, WINDOW* win, input_event_t& ev) {
+    queued.clear();
+    queued_targets.clear();
+    queued.push_back(ev);
+    queued_targets.push_back(scr->window_at(ev.mouse.y, ev.mouse.x));
+
+    /* Events from the barrier on are motion */
+    std::size_t barrier = 0;
+    input_event_t next;
+    while ((queued.size() < max_read_ahead) && read_input(win, next)) {
+      if ((next.key != KEY_MOUSE) || !is_mouse_motion(next.mouse)) {
+        queued.push_back(next);
+        queued_targets.push_back(NULL);
+        barrier = queued.size();
+        continue;
+      }
+
+      Window* target = scr->window_at(next.mouse.y, next.mouse.x);
+      std::size_t i = barrier;
+      while ((i < queued.size()) && (queued_targets[i] != target)) {
+        ++i;
+      }
+      if (i < queued.size()) {
+        queued[i] = next;
+      } else {
+        queued.push_back(next);
+        queued_targets.push_back(target);
+      }
+    }
+
+    ev = queued[0];
+    queued_next = 1;
+  }
+
+  bool start_recording(FILE* fp) {
+    if (recorder || (fp == NULL)) {
+      return false;
+    }
+    recorder.reset(new frame_recorder_t(fp));
+    return true;
+  }
+
+  void stop_recording() {
+    recorder.reset();
+  }
+
+  void damage(WINDOW* win) {
+    if (recorder) {
+      recorder->damage(win);
+    }
+  }
+
+  void damage_all() {
+    if (recorder) {
+      recorder->damage_all();
+    }
+  }
+
+  void record_frame() {
+    styles.take_recycled(recycled_pairs);
+    if (recorder) {
+      recorder->recolor(recycled_pairs);
+      recorder->frame();
     }
   }
 };
 
-Screen::Screen() : focused_win(NULL), pimpl(new ScreenImpl()) {
+Screen::Screen() : Screen(NULL, stdout, stdin, false) {
 
 }
 
-Screen::~Screen() {
+Screen::Screen(const char* type, FILE* out, FILE* in, bool buffered) :
+  pimpl(new ScreenImpl(type, out, in, buffered)), num_windows(0),
+  focused_win(NULL), focus_path_valid(false), layout_dir(LAYOUT_COLUMN),
+  layout_pending(false), layout_lines(0), layout_cols(0), looped(false),
+  busy(0), dispatch_depth(0) {
 
+  current = this;
+  screens.push_back(this);
+}
+
+Screen::~Screen() {
+  if (current == this) {
+    current = NULL;
+  }
+  screens.erase(
+      std::remove(screens.begin(), screens.end(), this),
+      screens.end()
+    );
 }
 
 Screen& Screen::get_instance() {
+  std::lock_guard<std::recursive_mutex> guard(ncurses_lock);
   static Screen instance;
   return instance;
 }
 
+Screen& Screen::get_current() {
+  if (current == NULL) {
+    return get_instance();
+  }
+  return *current;
+}
+
+Screen* Screen::create_screen(const char* type, FILE* out, FILE* in) {
+  std::lock_guard<std::recursive_mutex> guard(ncurses_lock);
+
+  Screen* new_scr = NULL;
+  try {
+    new_scr = new Screen(type, out, in, true);
+  }
+  catch(std::exception e) {
+    return NULL;
+  }
+  return new_scr;
+}
+
+void Screen::destroy_screen(Screen* scr) {
+  if ((scr != NULL) && scr->pimpl->is_started()) {
+    scr->pimpl->exit_screen();
+    scr->pimpl->wake();
+    scr->pimpl->join();
+  }
+
+  std::lock_guard<std::recursive_mutex> guard(ncurses_lock);
+
+  if (scr != NULL) {
+    scr->end_screen();
+    scr->pimpl->release_term();
+    delete scr;
+  }
+
+  if (screens.empty()) {
+    for (auto term : released_terms) {
+      delscreen(term.first);
+      if (term.second != NULL) {
+        fclose(term.second);
+      }
+    }
+    released_terms.clear();
+  }
+}
+
+void Screen::lock() {
+  ncurses_lock.lock();
+}
+
+void Screen::unlock() {
+  ncurses_lock.unlock();
+}
+
+bool Screen::start() {
+  return pimpl->start(this);
+}
+
+void Screen::join() {
+  pimpl->join();
+}
+
+void Screen::activate() {
+  if (current != this) {
+    set_term(pimpl->get_term());
+    current = this;
+  }
+}
+
 int Screen::set_cursor(int visibility) {
+  activate();
   return pimpl->set_cursor(visibility);
 }
 
 void Screen::enable_color() {
+  activate();
   pimpl->enable_color();
 }
 
-void Screen::enable_mouse_events() {
-  pimpl->enable_mouse_events();
+style_id_t Screen::add_style(const style_t& style) {
+  return pimpl->add_style(style);
+}
+
+keymap_t& Screen::get_keymap() {
+  return pimpl->get_keymap();
+}
+
+bool Screen::resolve_style(style_id_t id, attr_t& attrs, short& pair,
+    bool pin) {
+  return pimpl->resolve_style(id, attrs, pair, pin);
+}
+
+void Screen::unpin_style(style_id_t id) {
+  pimpl->unpin_style(id);
+}
+
+void Screen::enable_mouse_events(mouse_motion_t motion) {
+  activate();
+  pimpl->enable_mouse_events(motion);
+}
+
+void Screen::set_escape_delay(int ms) {
+  activate();
+  set_escdelay(std::max(ms, 0));
+}
+
+int Screen::get_escape_delay() {
+  activate();
+  return get_escdelay();
 }
 
 void Screen::exit_screen() {
-  get_instance().pimpl->exit_screen();
+  get_current().pimpl->exit_screen();
 }
 
 bool Screen::should_exit() {
@@ -112,24 +789,70 @@ bool Screen::should_exit() {
 }
 
 void Screen::print(int y, int x, std::string &str) {
+  activate();
   pimpl->print(y, x, str);
 }
 
 void Screen::refresh() {
+  activate();
   pimpl->refresh();
 }
 
 void Screen::clear() {
+  activate();
   pimpl->clear();
 }
 
 void Screen::add_win(Window* win) {
   windows.push_back(win);
+  if (win->parent_window == NULL) {
+    stack.push_back(win);
+  }
   ++num_windows;
-  set_focus(win);
+
+  /* A new window only takes the focus if no textfield has it */
+  if (win->is_visible() && win->is_textfield() &&
+      ((focused_win == NULL) || !focused_win->is_textfield())) {
+    set_focus(win);
+  }
 }
 
 void Screen::remove_win(Window* win) {
+  doomed.erase(std::remove(doomed.begin(), doomed.end(), win), doomed.end());
+  if (std::find(focus_path.begin(), focus_path.end(), win) !=
+      focus_path.end()) {
+    focus_path_valid = false;
+  }
+  if (focused_win == win) {
+    focused_win = NULL;
+  }
+  for (auto& view : views) {
+    std::vector<std::pair<Window*, win_snapshot_t*> >& snaps = view.second;
+    for (std::size_t i = snaps.size(); i > 0; i--) {
+      if (snaps[i - 1].first == win) {
+        Window::destroy_snapshot(snaps[i - 1].second);
+        snaps.erase(snaps.begin() + (i - 1));
+      }
+    }
+  }
+  stack.erase(std::remove(stack.begin(), stack.end(), win), stack.end());
+  for (std::size_t i = popups.size(); i > 0; i--) {
+    popup_t& popup = popups[i - 1];
+    if (popup.focus == win) {
+      popup.focus = NULL;
+    }
+    if (popup.win == win) {
+      if (popup.saved != NULL) {
+        delwin(popup.saved);
+      }
+      popups.erase(popups.begin() + (i - 1));
+    }
+  }
+  for (std::size_t i = under.size(); i > 0; i--) {
+    if ((under[i - 1].first == win) || (under[i - 1].second == win)) {
+      under.erase(under.begin() + (i - 1));
+    }
+  }
   try {
     windows.erase(
         std::remove( windows.begin(), windows.end(), win),
@@ -143,6 +866,13 @@ void Screen::remove_win(Window* win) {
 }
 
 void Screen::end_screen() {
+  activate();
+  pimpl->stop_recording();
+  pimpl->stop_recording_input();
+  pimpl->disable_mouse_events();
+  while (!views.empty()) {
+    drop_view(views.begin()->first);
+  }
   while (!windows.empty()) {
     Window* win = windows.back();
     Window::destroy_win(win);
@@ -150,28 +880,787 @@ void Screen::end_screen() {
   endwin();
 }
 
+void Screen::set_layout(layout_dir_t dir) {
+  if (layout_dir != dir) {
+    layout_dir = dir;
+    request_layout();
+  }
+}
+
+void Screen::request_layout() {
+  layout_pending = true;
+}
+
+void Screen::layout() {
+  layout_pending = false;
+
+  bool resized = (layout_lines != LINES) || (layout_cols != COLS);
+  layout_lines = LINES;
+  layout_cols = COLS;
+
+  std::vector<Window*> managed;
+  std::vector<size_spec_t> specs;
+  for (auto w : windows) {
+    if ((w->parent_window == NULL) && w->is_managed()) {
+      size_spec_t h_spec, w_spec;
+      w->get_size(h_spec, w_spec);
+      managed.push_back(w);
+      specs.push_back((layout_dir == LAYOUT_ROW) ? w_spec : h_spec);
+    }
+  }
+
+  if (managed.empty()) {
+    return;
+  }
+
+  std::vector<int> sizes(managed.size(), 0);
+  if (layout_dir != LAYOUT_NONE) {
+    layout_distribute(&specs[0], managed.size(),
+        (layout_dir == LAYOUT_ROW) ? COLS : LINES, &sizes[0]);
+  }
+
+  bool changed = false;
+  int offset = 0;
+  for (std::size_t i = 0; i < managed.size(); i++) {
+    size_spec_t h_spec, w_spec;
+    managed[i]->get_size(h_spec, w_spec);
+
+    int h = h_spec.resolve(LINES);
+    int w = w_spec.resolve(COLS);
+    int y = 0;
+    int x = 0;
+
+    if (layout_dir == LAYOUT_ROW) {
+      w = sizes[i];
+      x = offset;
+      offset += w;
+    } else if (layout_dir == LAYOUT_COLUMN) {
+      h = sizes[i];
+      y = offset;
+      offset += h;
+    }
+
+    if (managed[i]->layout(h, w, y, x, resized)) {
+      changed = true;
+    }
+  }
+
+  /* Windows without a parent leave stale cells behind when they move */
+  if (changed) {
+    repaint();
+  }
+}
+
+void Screen::repaint() {
+  drop_saved(NULL);
+  ::erase();
+  wnoutrefresh(stdscr);
+  pimpl->damage_all();
+  for (auto w : windows) {
+    if (w->is_realized()) {
+      touchwin(w->get_win_handle());
+      w->mark_dirty();
+    }
+  }
+}
+
 void Screen::update() {
+  activate();
+  enter();
+  if (layout_pending) {
+    layout();
+  }
+
   if (num_windows > 0) {
-    for (auto w : windows) {
-      w->update();
+    /* Windows are copied to the virtual screen bottom to top and the frame
+     * is output once, callbacks may add windows */
+    bool drawn = false;
+    for (std::size_t i = 0; i < stack.size(); i++) {
+      if (compose(stack[i])) {
+        drawn = true;
+      }
+    }
+
+    /* Windows destroyed by handlers are deleted before the frame is output,
+     * the windows they uncover are composed again */
+    if (leave()) {
+      for (std::size_t i = 0; i < stack.size(); i++) {
+        if (compose(stack[i])) {
+          drawn = true;
+        }
+      }
+    }
+    if (drawn) {
+      doupdate();
     }
   }
   else {
+    leave();
     pimpl->update();
   }
+
+  pimpl->record_frame();
+}
+
+bool Screen::compose(Window* win) {
+  if (!win->is_visible() || is_doomed(win)) {
+    return false;
+  }
+
+  bool drawn = win->compose();
+  if (drawn) {
+    pimpl->damage(win->get_win_handle());
+  }
+  for (std::size_t i = 0; i < win->children.size(); i++) {
+    if (compose(win->children[i])) {
+      drawn = true;
+    }
+  }
+  return drawn;
+}
+
+static bool overlaps(WINDOW* a, WINDOW* b) {
+  int ay, ax, ah, aw, by, bx, bh, bw;
+  getbegyx(a, ay, ax);
+  getmaxyx(a, ah, aw);
+  getbegyx(b, by, bx);
+  getmaxyx(b, bh, bw);
+  return (ay < by + bh) && (by < ay + ah) && (ax < bx + bw) && (bx < ax + aw);
+}
+
+bool Screen::cull(Window* win) {
+  Window* root = win;
+  while (root->parent_window != NULL) {
+    root = root->parent_window;
+  }
+  auto it = std::find(stack.begin(), stack.end(), root);
+  if (it == stack.end()) {
+    return false;
+  }
+
+  WINDOW* handle = win->get_win_handle();
+  occluders.clear();
+  for (++it; it != stack.end(); ++it) {
+    if ((*it)->is_realized() && (*it)->is_visible() &&
+        overlaps((*it)->get_win_handle(), handle)) {
+      occluders.push_back(*it);
+    }
+  }
+  if (occluders.empty()) {
+    return false;
+  }
+
+  int y, x, h, w;
+  getbegyx(handle, y, x);
+  getmaxyx(handle, h, w);
+
+  bool culled = false;
+  for (int row = 0; row < h; row++) {
+    if (!is_linetouched(handle, row)) {
+      continue;
+    }
+
+    /* Sweep the windows above from the left edge of the line */
+    int line = y + row;
+    int from = x;
+    bool covered = false;
+    for (bool moved = true; moved && (from < x + w); ) {
+      moved = false;
+      for (auto above : occluders) {
+        WINDOW* a = above->get_win_handle();
+        int ay = getbegy(a);
+        int ax = getbegx(a);
+        if ((line < ay) || (line >= ay + getmaxy(a))) {
+          continue;
+        }
+        covered = true;
+        if ((ax <= from) && (from < ax + getmaxx(a))) {
+          from = ax + getmaxx(a);
+          moved = true;
+        }
+      }
+    }
+
+    if (from >= x + w) {
+      wtouchln(handle, row, 1, 0);
+      culled = true;
+    } else if (covered) {
+      for (auto above : occluders) {
+        WINDOW* a = above->get_win_handle();
+        int ay = getbegy(a);
+        if ((line >= ay) && (line < ay + getmaxy(a))) {
+          wtouchln(a, line - ay, 1, 1);
+          above->mark_dirty();
+        }
+      }
+    }
+
+    /* Cells saved under popups covering the line are stale */
+    if (covered && !popups.empty()) {
+      for (auto above : occluders) {
+        WINDOW* a = above->get_win_handle();
+        int ay = getbegy(a);
+        if ((line < ay) || (line >= ay + getmaxy(a)) ||
+            (find_popup(above) == NULL)) {
+          continue;
+        }
+        std::pair<Window*, Window*> entry(root, above);
+        if (std::find(under.begin(), under.end(), entry) == under.end()) {
+          under.push_back(entry);
+        }
+      }
+    }
+  }
+  return culled;
+}
+
+void Screen::retouch(Window* win) {
+  WINDOW* handle = win->get_win_handle();
+  for (auto w : stack) {
+    if ((w != win) && w->is_realized() && w->is_visible() &&
+        overlaps(w->get_win_handle(), handle)) {
+      touchwin(w->get_win_handle());
+      w->mark_dirty();
+    }
+  }
+}
+
+void Screen::expose(Window* win) {
+  activate();
+
+  /* Cells outside of any window are those of stdscr, only the blanked or
+   * restored ones are copied */
+  wtouchln(stdscr, 0, getmaxy(stdscr), 0);
+  WINDOW* handle = win->get_win_handle();
+  popup_t* popup = find_popup(win);
+
+  if ((popup != NULL) && (popup->saved != NULL)) {
+    /* copywin would touch the whole lines of stdscr */
+    int h, w;
+    getmaxyx(popup->saved, h, w);
+    std::vector<chtype> row(w + 1);
+    for (int i = 0; i < h; i++) {
+      mvwinchnstr(popup->saved, i, 0, row.data(), w);
+      mvwaddchnstr(stdscr, popup->y + i, popup->x, row.data(), w);
+    }
+    wnoutrefresh(stdscr);
+    pimpl->damage(handle);
+
+    /* Windows that changed under the popup, or are above it, are drawn
+     * again */
+    for (auto it = std::find(stack.begin(), stack.end(), win);
+        it != stack.end(); ++it) {
+      if ((*it != win) && (*it)->is_realized() && (*it)->is_visible() &&
+          overlaps((*it)->get_win_handle(), handle)) {
+        touchwin((*it)->get_win_handle());
+        (*it)->mark_dirty();
+      }
+    }
+    for (std::size_t i = under.size(); i > 0; i--) {
+      if (under[i - 1].second != win) {
+        continue;
+      }
+      Window* below = under[i - 1].first;
+      if (below->is_realized() && below->is_visible()) {
+        touchwin(below->get_win_handle());
+        below->mark_dirty();
+      }
+      under.erase(under.begin() + (i - 1));
+    }
+    delwin(popup->saved);
+    popup->saved = NULL;
+    return;
+  }
+
+  int y, x, h, w;
+  getbegyx(handle, y, x);
+  getmaxyx(handle, h, w);
+  int x0 = std::max(x, 0);
+  int x1 = std::min(x + w, COLS);
+  for (int row = std::max(y, 0); (row < y + h) && (row < LINES); row++) {
+    if (x0 < x1) {
+      mvwhline(stdscr, row, x0, ' ', x1 - x0);
+    }
+  }
+  wnoutrefresh(stdscr);
+  pimpl->damage(handle);
+
+  drop_saved(win);
+  retouch(win);
+}
+
+Screen::popup_t* Screen::find_popup(Window* win) {
+  for (auto& popup : popups) {
+    if (popup.win == win) {
+      return &popup;
+    }
+  }
+  return NULL;
+}
+
+void Screen::drop_saved(Window* win) {
+  WINDOW* handle = (win != NULL) ? win->get_win_handle() : NULL;
+  for (auto& popup : popups) {
+    if ((popup.saved != NULL) && (popup.win != win) &&
+        ((handle == NULL) ||
+         overlaps(popup.win->get_win_handle(), handle))) {
+      delwin(popup.saved);
+      popup.saved = NULL;
+    }
+  }
+}
+
+Window* Screen::get_modal() {
+  for (auto it = popups.rbegin(); it != popups.rend(); ++it) {
+    if (it->modal && it->win->is_visible()) {
+      return it->win;
+    }
+  }
+  return NULL;
+}
+
+bool Screen::push_popup(Window* win, bool modal) {
+  if ((win->parent_window != NULL) || (win->screen != this) ||
+      (find_popup(win) != NULL)) {
+    return false;
+  }
+  activate();
+
+  bool shown = win->is_visible();
+  win->raise();
+  win->show();
+
+  popup_t popup = { win, NULL, 0, 0, modal, focused_win };
+
+  /* The virtual screen holds the cells under a popup not drawn yet */
+  WINDOW* handle = win->get_win_handle();
+  if (!shown && (handle != NULL)) {
+    int y, x, h, w;
+    getbegyx(handle, y, x);
+    getmaxyx(handle, h, w);
+    popup.y = std::max(y, 0);
+    popup.x = std::max(x, 0);
+    h = std::min(y + h, LINES) - popup.y;
+    w = std::min(x + w, COLS) - popup.x;
+    if ((h > 0) && (w > 0)) {
+      popup.saved = newpad(h, w);
+    }
+    if (popup.saved != NULL) {
+      copywin(newscr, popup.saved, popup.y, popup.x, 0, 0, h - 1, w - 1,
+          FALSE);
+    }
+  }
+  popups.push_back(popup);
+
+  if (modal) {
+    Window* field = NULL;
+    std::vector<Window*> pending(1, win);
+    while (!pending.empty() && (field == NULL)) {
+      Window* w = pending.back();
+      pending.pop_back();
+      if (w->is_textfield() && w->is_visible()) {
+        field = w;
+      }
+      pending.insert(pending.end(), w->children.rbegin(), w->children.rend());
+    }
+    if (field != NULL) {
+      set_focus(field);
+    }
+  }
+  return true;
+}
+
+void Screen::pop_popup() {
+  if (popups.empty()) {
+    return;
+  }
+
+  Window* win = popups.back().win;
+  win->hide();
+
+  /* Hiding may have removed the popup */
+  if (popups.empty() || (popups.back().win != win)) {
+    return;
+  }
+  popup_t popup = popups.back();
+  popups.pop_back();
+  if (popup.saved != NULL) {
+    delwin(popup.saved);
+  }
+  if ((popup.focus != NULL) && popup.focus->is_visible()) {
+    set_focus(popup.focus);
+  }
+}
+
+Window* Screen::get_popup() {
+  return (popups.empty()) ? NULL : popups.back().win;
+}
+
+void Screen::restack(Window* win, bool top) {
+  auto it = std::find(stack.begin(), stack.end(), win);
+  if (it == stack.end()) {
+    return;
+  }
+  stack.erase(it);
+  if (top) {
+    stack.push_back(win);
+  } else {
+    stack.insert(stack.begin(), win);
+  }
+
+  if (!win->is_realized() || !win->is_visible()) {
+    return;
+  }
+  drop_saved(win);
+
+  /* A raised window is drawn over the others, the others over a lowered
+   * one */
+  if (top) {
+    touchwin(win->get_win_handle());
+    win->mark_dirty();
+  } else {
+    retouch(win);
+  }
+}
+
+void Screen::set_input_source(input_source* src) {
+  pimpl->set_input_source(src);
+}
+
+bool Screen::start_recording_input(FILE* fp) {
+  return pimpl->start_recording_input(fp);
+}
+
+void Screen::stop_recording_input() {
+  pimpl->stop_recording_input();
+}
+
+bool Screen::read_input(Window* win, input_event_t& ev) {
+  WINDOW* handle = win->get_win_handle();
+  if (handle == NULL) {
+    return false;
+  }
+  if (pimpl->next_queued(ev)) {
+    return true;
+  }
+  if (!pimpl->read_input(handle, ev)) {
+    return false;
+  }
+  if ((ev.key == KEY_MOUSE) && is_mouse_motion(ev.mouse)) {
+    pimpl->coalesce_motion(this, handle, ev);
+  }
+  return true;
+}
+
+bool Screen::start_recording(FILE* fp) {
+  activate();
+  return pimpl->start_recording(fp);
+}
+
+void Screen::stop_recording() {
+  pimpl->stop_recording();
+}
+
+bool Screen::reads_input() {
+  return (focused_win != NULL) && focused_win->is_textfield();
 }
 
 void Screen::mainloop() {
+  std::unique_lock<std::recursive_mutex> guard(ncurses_lock);
+
   while(!should_exit()) {
+    activate();
+    pimpl->run_posted();
+    pimpl->run_timers();
     update();
+    if (!should_exit()) {
+      int timeout = pimpl->prepare(reads_input());
+
+      /* Other screens run while this one waits */
+      guard.unlock();
+      int count = pimpl->wait_events(timeout);
+      guard.lock();
+
+      activate();
+      pimpl->dispatch_events(count);
+    }
+  }
+}
+
+void Screen::mainloop_all() {
+  int loop_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (loop_fd == -1) {
+    return;
+  }
+
+  std::unique_lock<std::recursive_mutex> guard(ncurses_lock);
+
+  /* The epoll set of each screen is nested in the one of the loop. Sets of
+   * destroyed screens leave it when they are closed. */
+  for (;;) {
+    int timeout = -1;
+    bool running = false;
+
+    /* Screens may be created and destroyed by callbacks */
+    for (std::size_t i = 0; i < screens.size(); i++) {
+      Screen* scr = screens[i];
+
+      /* Screens with a render thread of their own */
+      if (scr->pimpl->is_started()) {
+        continue;
+      }
+
+      if (!scr->should_exit()) {
+        scr->activate();
+        scr->pimpl->run_posted();
+        scr->pimpl->run_timers();
+        scr->update();
+      }
+
+      if (scr->should_exit()) {
+        if (scr->looped) {
+          epoll_ctl(loop_fd, EPOLL_CTL_DEL, scr->pimpl->get_epoll_fd(), NULL);
+          scr->looped = false;
+        }
+        continue;
+      }
+
+      if (!scr->looped) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = scr;
+        epoll_ctl(loop_fd, EPOLL_CTL_ADD, scr->pimpl->get_epoll_fd(), &ev);
+        scr->looped = true;
+      }
+
+      running = true;
+      int scr_timeout = scr->pimpl->prepare(scr->reads_input());
+      if ((scr_timeout >= 0) && ((timeout < 0) || (scr_timeout < timeout))) {
+        timeout = scr_timeout;
+      }
+    }
+
+    if (!running) {
+      break;
+    }
+
+    struct epoll_event events[16];
+    guard.unlock();
+    int count = epoll_wait(loop_fd, events, 16, timeout);
+    guard.lock();
+
+    for (int i = 0; i < count; i++) {
+      Screen* scr = (Screen*)events[i].data.ptr;
+      /* An earlier callback may have destroyed the screen */
+      if (std::find(screens.begin(), screens.end(), scr) == screens.end()) {
+        continue;
+      }
+      scr->activate();
+      scr->pimpl->poll();
+    }
+  }
+
+  close(loop_fd);
+}
+
+timer_id_t Screen::add_timer(
+    unsigned long ms,
+    timer_cb_t cb,
+    timer_cb_data_t cb_data,
+    bool periodic
+  ) {
+
+  return pimpl->add_timer(ms, cb, cb_data, periodic);
+}
+
+bool Screen::cancel_timer(timer_id_t id) {
+  return pimpl->cancel_timer(id);
+}
+
+void Screen::post(scr_cb_t cb, scr_cb_data_t cb_data) {
+  pimpl->post(cb, cb_data);
+}
+
+bool Screen::watch_fd(int fd, int events, fd_cb_t cb, fd_cb_data_t cb_data) {
+  return pimpl->watch_fd(fd, events, cb, cb_data);
+}
+
+bool Screen::unwatch_fd(int fd) {
+  return pimpl->unwatch_fd(fd);
+}
+
+void Screen::note_input() {
+  pimpl->note_input();
+}
+
+void Screen::build_path(Window* p_win, std::vector<Window*>& path) {
+  path.clear();
+  for (; p_win != NULL; p_win = p_win->parent_window) {
+    path.push_back(p_win);
+  }
+  std::reverse(path.begin(), path.end());
+}
+
+void Screen::enter() {
+  ++busy;
+}
+
+bool Screen::leave() {
+  if ((--busy > 0) || doomed.empty()) {
+    return false;
+  }
+  /* Deleting a window may destroy others, which are deleted at once */
+  std::vector<Window*> dead;
+  dead.swap(doomed);
+  for (std::size_t i = 0; i < dead.size(); i++) {
+    delete dead[i];
+  }
+  return true;
+}
+
+bool Screen::defer_destroy(Window* win) {
+  if (busy == 0) {
+    return false;
+  }
+  if (!is_doomed(win)) {
+    doomed.push_back(win);
+  }
+  return true;
+}
+
+void Screen::dispatch(win_event_t ev, Event& e, win_ev_cb_data_t cb_data) {
+  enter();
+  ++dispatch_depth;
+
+  /* A dispatch from a handler walks a path of its own, the paths of the
+   * screen are being walked */
+  std::vector<Window*> nested;
+  std::vector<Window*>* p_path = &event_path;
+  if (dispatch_depth > 1) {
+    build_path(e.target, nested);
+    p_path = &nested;
+  } else if (e.target == focused_win) {
+    if (!focus_path_valid) {
+      build_path(focused_win, focus_path);
+      focus_path_valid = true;
+    }
+    p_path = &focus_path;
+  } else {
+    build_path(e.target, event_path);
+  }
+
+  /* Handlers changing the focus do not alter the path being walked, the focus
+   * path is only rebuilt by the next dispatch */
+  std::vector<Window*>& path = *p_path;
+  std::size_t depth = path.size();
+
+  /* The walk stops at a window destroyed by a handler */
+  e.phase = EV_PHASE_CAPTURE;
+  for (std::size_t i = 0; (i + 1 < depth) && !e.stopped; i++) {
+    if (is_doomed(path[i])) {
+      e.stopped = true;
+      break;
+    }
+    e.window = path[i];
+    path[i]->notify(ev, e, cb_data);
+  }
+
+  if ((depth > 0) && !e.stopped && !is_doomed(path[depth - 1])) {
+    e.phase = EV_PHASE_TARGET;
+    e.window = path[depth - 1];
+    path[depth - 1]->notify(ev, e, cb_data);
+  }
+
+  e.phase = EV_PHASE_BUBBLE;
+  for (std::size_t i = depth - 1; (depth > 0) && (i > 0) && !e.stopped;
+      i--) {
+    if (is_doomed(path[i - 1])) {
+      break;
+    }
+    e.window = path[i - 1];
+    path[i - 1]->notify(ev, e, cb_data);
+  }
+
+  --dispatch_depth;
+  leave();
+}
+
+void Screen::save_view(int id) {
+  drop_view(id);
+
+  std::vector<std::pair<Window*, win_snapshot_t*> >& snaps = views[id];
+  snaps.reserve(windows.size());
+  for (auto w : windows) {
+    /* Children share the cells of their parent */
+    snaps.push_back(
+        std::make_pair(w, w->snapshot(w->parent_window == NULL)));
+  }
+}
+
+bool Screen::restore_view(int id) {
+  auto it = views.find(id);
+  if (it == views.end()) {
+    return false;
   }
+
+  activate();
+  for (auto& snap : it->second) {
+    snap.first->restore(snap.second);
+  }
+  return true;
+}
+
+void Screen::drop_view(int id) {
+  auto it = views.find(id);
+  if (it == views.end()) {
+    return;
+  }
+
+  for (auto& snap : it->second) {
+    Window::destroy_snapshot(snap.second);
+  }
+  views.erase(it);
+}
+
+Window* Screen::window_at(int y, int x) {
+  /* Input outside of a modal popup goes to the focused window */
+  Window* modal = get_modal();
+  if (modal != NULL) {
+    return hit(modal, y, x);
+  }
+
+  /* Windows higher in the stacking order are drawn over lower ones, and
+   * children added later over earlier ones */
+  for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+    Window* w = hit(*it, y, x);
+    if (w != NULL) {
+      return w;
+    }
+  }
+  return NULL;
+}
+
+Window* Screen::hit(Window* win, int y, int x) {
+  if (!win->enclose(y, x)) {
+    return NULL;
+  }
+  for (auto it = win->children.rbegin(); it != win->children.rend(); ++it) {
+    Window* w = hit(*it, y, x);
+    if (w != NULL) {
+      return w;
+    }
+  }
+  return win;
 }
 
 void Screen::set_focus(Window *p_win) {
+  /* The previously focused window is drawn with the next frame */
   if (focused_win) {
-    focused_win->draw();
+    focused_win->mark_dirty();
   }
   focused_win = p_win;
+  focus_path_valid = false;
   if (p_win->is_textfield()) {
     for (auto w : windows) {
       w->set_focus((w == p_win));
@@ -181,11 +1670,42 @@ void Screen::set_focus(Window *p_win) {
 
 void Screen::set_focus_next(Window *p_win) {
   auto res = std::find(windows.begin(), windows.end(), p_win);
-  do {
+  Window* modal = get_modal();
+  /* Hidden textfields, and those outside of a modal popup, are skipped */
+  for (std::size_t i = 0; i < windows.size(); i++) {
     ++res;
     if (res == windows.end()) {
       res = windows.begin();
     }
-  } while (!(*res)->is_textfield());
-  set_focus(*res);
+    Window* root = *res;
+    while ((modal != NULL) && (root->parent_window != NULL)) {
+      root = root->parent_window;
+    }
+    if ((*res)->is_textfield() && (*res)->is_visible() &&
+        ((modal == NULL) || (root == modal))) {
+      set_focus(*res);
+      return;
+    }
+  }
+}
+
+void Screen::set_focus_prev(Window *p_win) {
+  auto res = std::find(windows.begin(), windows.end(), p_win);
+  Window* modal = get_modal();
+  /* Hidden textfields, and those outside of a modal popup, are skipped */
+  for (std::size_t i = 0; i < windows.size(); i++) {
+    if (res == windows.begin()) {
+      res = windows.end();
+    }
+    --res;
+    Window* root = *res;
+    while ((modal != NULL) && (root->parent_window != NULL)) {
+      root = root->parent_window;
+    }
+    if ((*res)->is_textfield() && (*res)->is_visible() &&
+        ((modal == NULL) || (root == modal))) {
+      set_focus(*res);
+      return;
+    }
+  }
 }
@@ -0,0 +1,187 @@
+/*
+ * @file ncui_style.cc
+ * @author notweerdmonk
+ * @brief Intern styles and cache their color pairs.
+ */
+
+#include <ncui_style.h>
+
+using namespace ncui;
+
+static uint64_t style_key(const style_t& s) {
+  return ((uint64_t)s.attrs << 32) |
+    ((uint32_t)(uint16_t)s.fg << 16) | (uint16_t)s.bg;
+}
+
+uint32_t style_cache::color_key(short fg, short bg) {
+  return ((uint32_t)(uint16_t)fg << 16) | (uint16_t)bg;
+}
+
+style_cache::style_cache() :
+  head(NIL), tail(NIL), max_pairs(0), colors(false), default_colors(false),
+  inits(0) {
+
+  /* The default style has id 0 and pair 0 */
+  styles.push_back(style_t());
+  style_pairs.push_back(NIL);
+  ids[style_key(style_t())] = 0;
+}
+
+void style_cache::reset() {
+  colors = has_colors() && (COLOR_PAIRS > 1);
+
+  /* Pairs of cells do not fit more bits than those of A_COLOR */
+  max_pairs = std::min(COLOR_PAIRS, (int)PAIR_NUMBER(A_COLOR) + 1);
+
+  /* The default colors of the terminal are -1 */
+  default_colors = colors && (use_default_colors() == OK);
+
+  pair_slot_t nil = { 0, 0, NIL, NIL };
+  slots.assign(1, nil);
+  pairs.clear();
+  head = tail = NIL;
+  recycled.clear();
+  std::fill(style_pairs.begin(), style_pairs.end(), (short)NIL);
+}
+
+void style_cache::link(short pair) {
+  pair_slot_t& slot = slots[pair];
+  slot.prev = NIL;
+  slot.next = head;
+  if (head != NIL) {
+    slots[head].prev = pair;
+  } else {
+    tail = pair;
+  }
+  head = pair;
+}
+
+void style_cache::unlink(short pair) {
+  pair_slot_t& slot = slots[pair];
+  if (slot.prev != NIL) {
+    slots[slot.prev].next = slot.next;
+  } else {
+    head = slot.next;
+  }
+  if (slot.next != NIL) {
+    slots[slot.next].prev = slot.prev;
+  } else {
+    tail = slot.prev;
+  }
+  slot.prev = slot.next = NIL;
+}
+
+short style_cache::acquire(short fg, short bg) {
+  uint32_t key = color_key(fg, bg);
+
+  auto it = pairs.find(key);
+  if (it != pairs.end()) {
+    short pair = it->second;
+    if (slots[pair].refs == 0) {
+      unlink(pair);
+      link(pair);
+    }
+    return pair;
+  }
+
+  short pair;
+  if ((int)slots.size() < max_pairs) {
+    pair = (short)slots.size();
+    pair_slot_t slot = { 0, 0, NIL, NIL };
+    slots.push_back(slot);
+  } else if (tail != NIL) {
+    pair = tail;
+    unlink(pair);
+    pairs.erase(slots[pair].key);
+    recycled.push_back(pair);
+  } else {
+    /* Every pair is pinned */
+    return NIL;
+  }
+
+  if (!default_colors) {
+    fg = (fg < 0) ? COLOR_WHITE : fg;
+    bg = (bg < 0) ? COLOR_BLACK : bg;
+  }
+  init_pair(pair, fg, bg);
+  ++inits;
+
+  slots[pair].key = key;
+  slots[pair].refs = 0;
+  pairs[key] = pair;
+  link(pair);
+  return pair;
+}
+
+style_id_t style_cache::add(const style_t& s) {
+  uint64_t key = style_key(s);
+  auto it = ids.find(key);
+  if (it != ids.end()) {
+    return it->second;
+  }
+
+  style_id_t id = (style_id_t)styles.size();
+  styles.push_back(s);
+  style_pairs.push_back(NIL);
+  ids[key] = id;
+  return id;
+}
+
+bool style_cache::resolve(style_id_t id, attr_t& attrs, short& pair,
+    bool pin) {
+
+  if ((id < 0) || (id >= (style_id_t)styles.size())) {
+    return false;
+  }
+
+  const style_t& s = styles[id];
+  attrs = s.attrs;
+  pair = NIL;
+
+  /* Pair 0 has the default colors */
+  if (!colors || ((s.fg < 0) && (s.bg < 0))) {
+    return true;
+  }
+
+  /* The pair resolved last time is still valid unless it was recycled */
+  short p = style_pairs[id];
+  if ((p != NIL) && (slots[p].key == color_key(s.fg, s.bg))) {
+    if (slots[p].refs == 0) {
+      unlink(p);
+      link(p);
+    }
+  } else {
+    p = acquire(s.fg, s.bg);
+    style_pairs[id] = p;
+    if (p == NIL) {
+      return true;
+    }
+  }
+
+  if (pin && (slots[p].refs++ == 0)) {
+    unlink(p);
+  }
+
+  pair = p;
+  return true;
+}
+
+void style_cache::unpin(style_id_t id) {
+  if ((id < 0) || (id >= (style_id_t)styles.size())) {
+    return;
+  }
+
+  short p = style_pairs[id];
+  if ((p != NIL) && (slots[p].refs > 0) && (--slots[p].refs == 0)) {
+    link(p);
+  }
+}
+
+void style_cache::take_recycled(std::vector<short>& out) {
+  out.clear();
+  out.swap(recycled);
+}
+
+unsigned long style_cache::get_inits() const {
+  return inits;
+}
@@ -0,0 +1,274 @@
+/*
+ * @file ncui_timer.cc
+ * @author notweerdmonk
+ * @brief Schedule and expire timers.
+ */
+
+#include <ncui_timer.h>
+
+using namespace ncui;
+
+/**
+ * @brief Find the next set bit after given position, wrapping around.
+ * @param bits The bitmap, must not be zero.
+ * @param idx The position to start after.
+ * @return The position of the set bit, idx itself comes last.
+ */
+static int next_slot(uint64_t bits, int idx) {
+  int r = (idx + 1) & (timer_wheel_t::SLOTS - 1);
+  uint64_t rot = (r != 0) ? ((bits >> r) | (bits << (64 - r))) : bits;
+  return (r + __builtin_ctzll(rot)) & (timer_wheel_t::SLOTS - 1);
+}
+
+uint64_t ncui::monotonic_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+timer_wheel::timer_wheel(uint64_t _now) : now(_now), free_head(NIL) {
+  for (int i = 0; i <= EXPIRING; i++) {
+    heads[i] = NIL;
+  }
+  for (int i = 0; i < LEVELS; i++) {
+    occupied[i] = 0;
+  }
+}
+
+void timer_wheel::link(int idx, int list) {
+  timer_node_t& node = nodes[idx];
+  node.list = list;
+  node.prev = NIL;
+  node.next = heads[list];
+  if (node.next != NIL) {
+    nodes[node.next].prev = idx;
+  }
+  heads[list] = idx;
+
+  if (list < EXPIRING) {
+    occupied[list / SLOTS] |= (1ULL << (list % SLOTS));
+  }
+}
+
+void timer_wheel::unlink(int idx) {
+  timer_node_t& node = nodes[idx];
+  if (node.prev != NIL) {
+    nodes[node.prev].next = node.next;
+  } else {
+    heads[node.list] = node.next;
+  }
+  if (node.next != NIL) {
+    nodes[node.next].prev = node.prev;
+  }
+
+  if ((node.list < EXPIRING) && (heads[node.list] == NIL)) {
+    occupied[node.list / SLOTS] &= ~(1ULL << (node.list % SLOTS));
+  }
+
+  node.list = NIL;
+  node.prev = node.next = NIL;
+}
+
+void timer_wheel::schedule(int idx) {
+  uint64_t expires = nodes[idx].expires;
+
+  /* The current tick has been expired already */
+  if (expires <= now) {
+    expires = now + 1;
+  }
+
+  const uint64_t range = 1ULL << (LEVEL_BITS * LEVELS);
+  if (expires - now >= range) {
+    expires = now + range - 1;
+  }
+
+  uint64_t delta = expires - now;
+  int level = 0;
+  while ((level < LEVELS - 1) &&
+      (delta >= (1ULL << (LEVEL_BITS * (level + 1))))) {
+    ++level;
+  }
+
+  int slot = (expires >> (LEVEL_BITS * level)) & (SLOTS - 1);
+  link(idx, level * SLOTS + slot);
+}
+
+int timer_wheel::alloc_node() {
+  int idx = free_head;
+  if (idx != NIL) {
+    free_head = nodes[idx].next;
+  } else {
+    timer_node_t node;
+    node.gen = 0;
+    nodes.push_back(node);
+    idx = nodes.size() - 1;
+  }
+  nodes[idx].list = NIL;
+  nodes[idx].prev = nodes[idx].next = NIL;
+  return idx;
+}
+
+void timer_wheel::free_node(int idx) {
+  timer_node_t& node = nodes[idx];
+  ++node.gen;
+  node.cb = NULL;
+  node.cb_data = NULL;
+  node.list = NIL;
+  node.prev = NIL;
+  node.next = free_head;
+  free_head = idx;
+}
+
+timer_id_t timer_wheel::add(
+    uint64_t expires,
+    uint64_t period,
+    timer_cb_t cb,
+    timer_cb_data_t cb_data
+  ) {
+
+  int idx = alloc_node();
+  timer_node_t& node = nodes[idx];
+  node.expires = expires;
+  node.period = period;
+  node.cb = cb;
+  node.cb_data = cb_data;
+  schedule(idx);
+
+  return ((timer_id_t)node.gen << 32) | (timer_id_t)(idx + 1);
+}
+
+bool timer_wheel::cancel(timer_id_t id) {
+  int idx = (int)(id & 0xffffffffULL) - 1;
+  uint32_t gen = (uint32_t)(id >> 32);
+
+  if ((idx < 0) || (idx >= (int)nodes.size()) ||
+      (nodes[idx].gen != gen) || (nodes[idx].list == NIL)) {
+    return false;
+  }
+
+  unlink(idx);
+  free_node(idx);
+  return true;
+}
+
+void timer_wheel::cascade(int level) {
+  int list = level * SLOTS + ((now >> (LEVEL_BITS * level)) & (SLOTS - 1));
+  while (heads[list] != NIL) {
+    int idx = heads[list];
+    unlink(idx);
+    /* Timers due at the start of the turn are expired right away */
+    if (nodes[idx].expires <= now) {
+      link(idx, now & (SLOTS - 1));
+    } else {
+      schedule(idx);
+    }
+  }
+}
+
+void timer_wheel::expire() {
+  int list = now & (SLOTS - 1);
+  while (heads[list] != NIL) {
+    int idx = heads[list];
+    unlink(idx);
+    link(idx, EXPIRING);
+  }
+}
+
+int timer_wheel::advance(uint64_t _now) {
+  int count = 0;
+
+  while (now < _now) {
+    /* Skip ahead to the next occupied slot of level 0, or to the next turn
+     * of level 0 if timers on higher levels need to be cascaded */
+    uint64_t step = _now - now;
+    int idx = now & (SLOTS - 1);
+    if (occupied[0] != 0) {
+      int slot = next_slot(occupied[0], idx);
+      uint64_t dist = (slot - idx) & (SLOTS - 1);
+      step = std::min(step, (dist != 0) ? dist : (uint64_t)SLOTS);
+    }
+    if ((occupied[1] | occupied[2] | occupied[3]) != 0) {
+      step = std::min(step, (uint64_t)(SLOTS - idx));
+    }
+    now += step;
+
+    /* Cascade from the highest level whose turn is complete */
+    int level = 0;
+    while ((level < LEVELS - 1) &&
+        ((now & ((1ULL << (LEVEL_BITS * (level + 1))) - 1)) == 0)) {
+      ++level;
+    }
+    for (; level > 0; level--) {
+      cascade(level);
+    }
+
+    expire();
+
+    /* Callbacks may add and cancel timers, including the ones expiring */
+    while (heads[EXPIRING] != NIL) {
+      int node_idx = heads[EXPIRING];
+      unlink(node_idx);
+
+      timer_node_t& node = nodes[node_idx];
+      if (node.expires > now) {
+        schedule(node_idx);
+        continue;
+      }
+
+      timer_cb_t cb = node.cb;
+      timer_cb_data_t cb_data = node.cb_data;
+
+      if (node.period > 0) {
+        /* Keep the cadence, skipping periods that were missed */
+        node.expires += node.period *
+          (((now - node.expires) / node.period) + 1);
+        schedule(node_idx);
+      } else {
+        free_node(node_idx);
+      }
+
+      ++count;
+      if (cb != NULL) {
+        cb(cb_data);
+      }
+    }
+  }
+
+  return count;
+}
+
+int timer_wheel::next_timeout(uint64_t _now) {
+  uint64_t next = UINT64_MAX;
+
+  if (occupied[0] != 0) {
+    int idx = now & (SLOTS - 1);
+    int slot = next_slot(occupied[0], idx);
+    uint64_t dist = (slot - idx) & (SLOTS - 1);
+    next = now + ((dist != 0) ? dist : (uint64_t)SLOTS);
+  }
+
+  for (int level = 1; level < LEVELS; level++) {
+    if (occupied[level] == 0) {
+      continue;
+    }
+    int shift = LEVEL_BITS * level;
+    int idx = (now >> shift) & (SLOTS - 1);
+    int slot = next_slot(occupied[level], idx);
+
+    /* Start of the slot in the current turn of the level, or the next one */
+    uint64_t turn = 1ULL << (shift + LEVEL_BITS);
+    uint64_t start = ((now / turn) * turn) + ((uint64_t)slot << shift);
+    if (start <= now) {
+      start += turn;
+    }
+    next = std::min(next, start);
+  }
+
+  if (next == UINT64_MAX) {
+    return -1;
+  }
+  if (next <= _now) {
+    return 0;
+  }
+  return (int)std::min(next - _now, (uint64_t)INT32_MAX);
+}
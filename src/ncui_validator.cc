@@ -0,0 +1,145 @@
+/*
+ * @file ncui_validator.cc
+ * @author notweerdmonk
+ * @brief Compile constraints on the text of a textfield.
+ */
+
+#include <ncui_validator.h>
+
+using namespace ncui;
+
+/* Parse a charset with ranges such as "a-z" into a set of printable
+ * characters */
+static void parse_charset(const char* charset, bool* set) {
+  for (int c = 0; c < 128; c++) {
+    set[c] = (charset == NULL) && (c > 31) && (c < 127);
+  }
+  if (charset == NULL) {
+    return;
+  }
+
+  for (const char* p = charset; *p != '\0'; p++) {
+    int lo = (unsigned char)*p;
+    int hi = lo;
+    if ((p[1] == '-') && (p[2] != '\0')) {
+      hi = (unsigned char)p[2];
+      p += 2;
+    }
+    for (int c = std::max(lo, 32); c <= std::min(hi, 126); c++) {
+      set[c] = true;
+    }
+  }
+}
+
+/* Characters a column of a mask accepts, false if it is a literal */
+static bool mask_class(char m, const bool* charset, bool* set) {
+  for (int c = 0; c < 128; c++) {
+    bool in;
+    switch (m) {
+      case '9': in = isdigit(c); break;
+      case 'A': in = isalpha(c); break;
+      case 'X': in = isalnum(c); break;
+      case 'H': in = isxdigit(c); break;
+      case '*': in = true; break;
+      default:
+        return false;
+    }
+    set[c] = in && charset[c];
+  }
+  return true;
+}
+
+int field_validator::add_state() {
+  table.resize(table.size() + ASCII, REJECT);
+  literals.push_back('\0');
+  return (int)literals.size() - 1;
+}
+
+void field_validator::allow(int state, const bool* set, int next) {
+  for (int c = 0; c < ASCII; c++) {
+    if (set[c]) {
+      table[(state * ASCII) + c] = (uint8_t)next;
+    }
+  }
+}
+
+field_validator::field_validator(const field_constraints_t& c) :
+  max_len(c.max_len) {
+
+  bool charset[ASCII];
+  bool set[ASCII];
+  parse_charset(c.charset, charset);
+
+  add_state();    /* REJECT */
+  add_state();    /* START */
+
+  if (c.mask != NULL) {
+    /* One state before each column and one after the last */
+    int state = START;
+    int cols = 0;
+    for (const char* p = c.mask; *p != '\0'; p++, cols++) {
+      if (state == MAX_STATES - 1) {
+        throw std::invalid_argument("field_validator: mask is too long");
+      }
+      int next = add_state();
+      if ((*p != '\\') && mask_class(*p, charset, set)) {
+        allow(state, set, next);
+      } else {
+        if ((*p == '\\') && (p[1] != '\0')) {
+          ++p;
+        }
+        if ((*p < 32) || (*p > 126)) {
+          throw std::invalid_argument(
+              "field_validator: mask has a character that is not printable "
+              "ASCII");
+        }
+        literals[state] = *p;
+        table[(state * ASCII) + *p] = (uint8_t)next;
+      }
+      state = next;
+    }
+    max_len = (max_len > 0) ? std::min(max_len, cols) : cols;
+
+  } else if (c.numeric) {
+    int sign = add_state();
+    int integer = add_state();
+
+    memset(set, 0, sizeof(set));
+    set['-'] = charset['-'];
+    allow(START, set, sign);
+
+    for (int d = '0'; d <= '9'; d++) {
+      set[d] = charset[d];
+    }
+    set['-'] = false;
+    allow(START, set, integer);
+    allow(sign, set, integer);
+    allow(integer, set, integer);
+
+    /* A state for each digit after the decimal point */
+    int decimals = std::min(c.decimals, MAX_STATES - 5);
+    if ((decimals > 0) && charset['.']) {
+      int state = add_state();
+      table[(integer * ASCII) + '.'] = (uint8_t)state;
+      for (int i = 0; i < decimals; i++) {
+        int next = add_state();
+        allow(state, set, next);
+        state = next;
+      }
+    }
+
+  } else {
+    allow(START, charset, START);
+  }
+}
+
+int field_validator::run(const char* str, int len) const {
+  int state = START;
+  for (int col = 0; (col < len) && (str[col] != '\0'); col++) {
+    state = step(state, col, (unsigned char)str[col]);
+    if (state == REJECT) {
+      break;
+    }
+  }
+  return state;
+}
@@ -9,18 +9,29 @@
 
 /* TODO: use references instead of pointers */
 /* TODO: use forms library */
-/* TODO: invisible borders */
-/* TODO: title for windows */
 /* TODO: use ncursesw and support wide characters */
 
 using namespace ncui;
 
+struct ncui::win_snapshot {
+  WINDOW*        cells;   /**< A pad holding the cells, or NULL */
+  int            cur_y;
+  int            cur_x;
+  field_buf_t*   text;    /**< The text of a textfield, or NULL */
+};
+
 class Window::WindowImpl {
 
+  typedef struct {
+    int               id;
+    bool              capture;
+    raw_delegate      handler;
+  } win_ev_handler_t;
+
   typedef struct {
     win_ev_cb_t       cb;
-    win_ev_cb_data_t  cb_data;
     win_ev_user_data_t user_data;
+    std::vector<win_ev_handler_t> handlers;
   } win_ev_entry_t;
 
   typedef struct {
@@ -35,26 +46,105 @@ class Window::WindowImpl {
     int x, y;
   } cursor_t;
 
+  /* Matches of a prefix of the query, positions in the text sorted */
+  typedef struct {
+    std::size_t len;
+    std::vector<uint32_t> hits;
+  } find_level_t;
+
+  /* A highlighted cell of a window that is not scrollable */
+  typedef struct {
+    int y, x;
+    chtype orig;
+    chtype shown;
+  } find_cell_t;
+
   WINDOW*        win_handle;
 
   WINDOW*        parent_win_handle;
 
   Window*        win;
 
+  Window*        parent;
+
   bool           bordered  : 1;
   bool           textfield : 1;
   bool           dirty     : 1;
-  bool           was_resized  : 1;
   bool           has_focus    : 1;
+  bool           managed      : 1;
+  bool           layout_dirty : 1;
+  bool           layout_valid : 1;
+  bool           visible      : 1;
 
   field_buf_t*   p_text_buf;
 
+  /* Constraints of a textfield, with the state after the text before the
+   * cursor cached for the row and column it was computed at */
+  field_validator_t* validator;
+
+  /* Bindings of keys of the window, NULL if it has none of its own, and the
+   * table of the next key of a chord being typed */
+  keymap_t*      keys;
+  int            chord;
+
+  /* Edits kept in the journal of the text to be undone */
+  int            undo_limit;
+  int            val_row;
+  int            val_col;
+  int            val_state;
+
+  /* Styles of the background and the border, their pairs are pinned */
+  style_id_t     bg_style;
+  style_id_t     border_style;
+  chtype         bg_attrs;
+  chtype         border_attrs;
+
+  /* Cells of the border, built when its size, style, kind or title change
+   * and written again only if they were overwritten */
+  border_t       border_kind;
+  std::string    title;
+  std::vector<chtype> border_top;
+  std::vector<chtype> border_bottom;
+  chtype         border_side[2];
+  bool           border_built;
+
+  /* Text of adjacent spans of the same style */
+  std::string    run_buf;
+
+  /* Content of a scrollable window, the viewport is copied from it */
+  WINDOW*        pad;
+  int            pad_top;
+  int            pad_left;
+  bool           view_stale;
+
+  /* Cells of a hidden derived window, put back when it is shown */
+  WINDOW*        saved;
+
+  /* Text searched by find, rows of find_stride characters, and the matches
+   * of each prefix of the query typed so far */
+  std::string    find_text;
+  int            find_stride;
+  std::string    find_query;
+  std::vector<find_level_t> find_levels;
+  int            find_cur;
+  std::vector<find_cell_t> find_cells;
+  style_id_t     find_style;
+  style_id_t     find_cur_style;
+
   dim_t          win_dim;
   coord_t        win_coord;
   cursor_t       cur;
   dim_t          resize_dim;
 
+  dim_t          outer_dim;
+  layout_dir_t   layout_dir;
+  size_spec_t    h_spec;
+  size_spec_t    w_spec;
+
   win_ev_entry_t ev_lookup[WIN_EV_MAX];
+  int            next_handler_id;
+  int            dispatch_depth;
+  bool           handlers_removed;
   win_cb_t       update_cb;
   win_cb_data_t  update_cb_data;
 
@@ -64,37 +154,50 @@ class Window::WindowImpl {
 
   WindowImpl(
       Window* win,
-      WINDOW* parent_win,
+      Screen* scr,
+      Window* parent,
       const int h, const int w,
       const int y, const int x,
       bool bordered,
-      bool textfield
+      bool textfield,
+      bool visible
     ) {
 
     this->win = win;
+    this->parent = parent;
 
-    parent_win_handle = parent_win;
-
-    if (parent_win) {
-
-      win_handle = derwin(parent_win, h, w, y, x);
-      if (win_handle == NULL) {
-        throw std::runtime_error("WindowImpl: derwin failed");
-      }
-    } else {
+    /* Windows are created on the current terminal */
+    scr->activate();
 
-      win_handle = newwin(h, w, y, x);
-      if (win_handle == NULL) {
-        throw std::runtime_error("WindowImpl: newwin failed");
-      }
-    }
+    win_handle = NULL;
+    parent_win_handle = NULL;
 
     for (int i = 0; i < WIN_EV_MAX; i++) {
       ev_lookup[i].cb = NULL;
-      ev_lookup[i].cb_data = NULL;
       ev_lookup[i].user_data = NULL;
     }
 
+    bg_style = 0;
+    border_style = 0;
+    bg_attrs = 0;
+    border_attrs = 0;
+    border_kind = BORDER_LINE;
+    border_built = false;
+
+    pad = NULL;
+    pad_top = pad_left = 0;
+    view_stale = false;
+    saved = NULL;
+
+    find_stride = 0;
+    find_cur = -1;
+    find_style = 0;
+    find_cur_style = 0;
+
+    next_handler_id = 1;
+    dispatch_depth = 0;
+    handlers_removed = false;
+
     update_cb = &event_handler;
     update_cb_data = this;
 
@@ -104,6 +207,15 @@ class Window::WindowImpl {
     win_coord.x = x;
     cur.x = cur.y = 0;
 
+    outer_dim.h = h;
+    outer_dim.w = w;
+    dirty = false;
+    has_focus = false;
+    managed = false;
+    layout_dirty = false;
+    layout_valid = false;
+    layout_dir = LAYOUT_NONE;
+
     this->bordered = bordered;
     if (bordered == TRUE) {
       win_dim.h -= 2;
@@ -111,37 +223,296 @@ class Window::WindowImpl {
     }
 
     this->textfield = textfield;
-    if (textfield == TRUE) {
+    p_text_buf = NULL;
+    validator = NULL;
+    keys = NULL;
+    chord = 0;
+    undo_limit = 64;
+    val_row = val_col = -1;
+    val_state = field_validator_t::REJECT;
+
+    /* Hidden windows are realized when they are first shown */
+    this->visible = visible;
+    if (is_shown()) {
+      if (!realize()) {
+        throw std::runtime_error("WindowImpl: creating the window failed");
+      }
+      clearok(win_handle, TRUE);
+    }
+  }
+
+  ~WindowImpl() {
+    win->screen->unpin_style(bg_style);
+    win->screen->unpin_style(border_style);
+    if (win_handle != NULL) {
+      delwin(win_handle);
+    }
+    if (p_text_buf != NULL) {
+      delete p_text_buf;
+      p_text_buf = NULL;
+    }
+    delete validator;
+    delete keys;
+    if (pad != NULL) {
+      delwin(pad);
+    }
+    if (saved != NULL) {
+      delwin(saved);
+    }
+  }
+
+  /**
+   * @brief Create the ncurses window, after those of the ancestors, and draw
+   * what the window holds into it: the border, the background, the text of a
+   * textfield and the content of a scrollable window. Other contents are
+   * printed by the resize handlers, which are notified.
+   * @return true if the window is realized, false if it could not be created.
+   */
+  bool realize() {
+    if (win_handle != NULL) {
+      return true;
+    }
+
+    if (parent != NULL) {
+      if (!parent->pimpl->realize()) {
+        return false;
+      }
+      parent_win_handle = parent->pimpl->win_handle;
+      win_handle = derwin(parent_win_handle, outer_dim.h, outer_dim.w,
+          win_coord.y, win_coord.x);
+    } else {
+      win_handle = newwin(outer_dim.h, outer_dim.w, win_coord.y, win_coord.x);
+    }
+    if (win_handle == NULL) {
+      parent_win_handle = NULL;
+      return false;
+    }
+
+    if (bg_attrs != 0) {
+      wbkgd(win_handle, bg_attrs);
+    }
+
+    if (textfield) {
       keypad(win_handle, TRUE);
       nodelay(win_handle, TRUE);
 
-      p_text_buf = new field_buf_t(win_dim.h, win_dim.w);
+      if (p_text_buf == NULL) {
+        p_text_buf = new_text_buf();
+      }
     }
-    else {
-      p_text_buf = NULL;
+
+    werase(win_handle);
+    restore_border();
+    if (textfield) {
+      repaint_text();
+    } else {
+      move_cur(0, 0);
+    }
+    if (pad != NULL) {
+      view_stale = true;
     }
 
-    clear();
+    resize_dim = win_dim;
+    ResizeEvent resize_ev(win, win_dim.h, win_dim.w);
+    notify(WIN_EV_RESIZE, resize_ev, &resize_dim);
 
-    if (bordered == TRUE) {
-      box();
+    dirty = true;
+    return true;
+  }
+
+  /**
+   * @brief Realize the window and its visible descendants.
+   */
+  bool realize_tree() {
+    if (!realize()) {
+      return false;
     }
+    for (auto child : win->children) {
+      if (child->pimpl->visible) {
+        child->pimpl->realize_tree();
+      }
+    }
+    return true;
   }
 
-  ~WindowImpl() {
-    wclear(win_handle);
-    wrefresh(win_handle);
-    if (p_text_buf != NULL) {
-      delete p_text_buf;
-      p_text_buf = NULL;
+  /**
+   * @brief Delete the ncurses windows of the window and its descendants,
+   * those of the descendants first as ncurses requires.
+   */
+  void release_tree() {
+    for (auto child : win->children) {
+      child->pimpl->release_tree();
+    }
+    if (win_handle != NULL) {
+      delwin(win_handle);
+      win_handle = NULL;
+      parent_win_handle = NULL;
+    }
+    dirty = false;
+  }
+
+  bool is_shown() {
+    return visible && ((parent == NULL) || parent->pimpl->is_shown());
+  }
+
+  bool is_realized() {
+    return win_handle != NULL;
+  }
+
+  void show() {
+    if (visible) {
+      return;
+    }
+    visible = true;
+    if (!is_shown() || !realize_tree()) {
+      return;
+    }
+
+    if (saved != NULL) {
+      int h = std::min(getmaxy(win_handle), getmaxy(saved));
+      int w = std::min(getmaxx(win_handle), getmaxx(saved));
+      copywin(saved, win_handle, 0, 0, 0, 0, h - 1, w - 1, FALSE);
+      delwin(saved);
+      saved = NULL;
+    }
+    touchwin(win_handle);
+    dirty = true;
+  }
+
+  void hide(bool release) {
+    bool was_visible = visible;
+    visible = false;
+    if (win_handle == NULL) {
+      return;
+    }
+
+    if (parent != NULL) {
+      /* Cells of derived windows are those of the parent, a copy of them is
+       * kept and the ncurses windows, which are cheap, are always deleted */
+      if (!release && was_visible && (saved == NULL)) {
+        int h = getmaxy(win_handle);
+        int w = getmaxx(win_handle);
+        saved = newpad(h, w);
+        if (saved != NULL) {
+          copywin(win_handle, saved, 0, 0, 0, 0, h - 1, w - 1, FALSE);
+        }
+      }
+      werase(win_handle);
+      touchwin(parent_win_handle);
+      parent->pimpl->dirty = true;
+      release_tree();
+    } else {
+      if (was_visible) {
+        win->screen->expose(win);
+      }
+      if (release) {
+        release_tree();
+      }
     }
-    delwin(win_handle);
   }
 
   WINDOW* get_win_handle() {
     return win_handle;
   }
 
+  bool set_constraints(const field_constraints_t& c) {
+    if (!textfield) {
+      return false;
+    }
+    field_validator_t* compiled = new field_validator_t(c);
+    delete validator;
+    validator = compiled;
+    val_row = val_col = -1;
+    return true;
+  }
+
+  void clear_constraints() {
+    delete validator;
+    validator = NULL;
+  }
+
+  /**
+   * @brief Check a key typed in a textfield against its constraints. A
+   * literal of a mask the key skips over is put first.
+   * @param key The key.
+   * @return true if the key is accepted, false otherwise.
+   */
+  bool validate(int key) {
+    int row = p_text_buf->idx;
+    int col = p_text_buf->rows[row]->idx;
+    if ((row != val_row) || (col != val_col)) {
+      val_state = validator->run(p_text_buf->rows[row]->str, col);
+    }
+
+    int next = validator->step(val_state, col, key);
+    if (next == field_validator_t::REJECT) {
+      char lit = validator->literal(val_state);
+      if (lit == '\0') {
+        val_row = row;
+        val_col = col;
+        return false;
+      }
+      int after = validator->step(val_state, col, lit);
+      next = validator->step(after, col + 1, key);
+      if (next == field_validator_t::REJECT) {
+        val_row = row;
+        val_col = col;
+        return false;
+      }
+      input(lit);
+      ++col;
+    }
+
+    /* The state after the key, valid if it is put in the same row */
+    val_row = row;
+    val_col = col + 1;
+    val_state = next;
+    return true;
+  }
+
+  /**
+   * @brief Put a character typed in a textfield at the cursor.
+   * @param key The character, or 10 for a newline.
+   */
+  void input(int key) {
+    /* A newline is not added, ncurses would clear the rest of the row and
+     * the border with it */
+    if ((cur.x <= win_dim.w) && (key != 10)) {
+      if (key != 9) {
+        addchar(key);
+      }
+    }
+
+    if (key == 10) {
+      p_text_buf->newline();
+    }
+    else {
+      if (key != 9) {
+        p_text_buf->put(key);
+      }
+    }
+
+    /* Enter/Return key */
+    if (key == 10) {
+      int inset = (bordered) ? 1 : 0;
+      if (cur.y < win_dim.h - 1 + inset) {
+        move_cur(cur.y + 1, inset);
+      }
+    }
+    else if (bordered == true) {
+      if (cur.x > win_dim.w) {
+        if (cur.y < win_dim.h) {
+          move_cur(++cur.y, 1);
+        }
+        else if (cur.y == win_dim.h) {
+          if (textfield) {
+            p_text_buf->move_col_rel(-1);
+          }
+        }
+      }
+    }
+  }
+
   /**
    * @brief 
    * @param param An opaque pointer.
@@ -152,109 +523,122 @@ class Window::WindowImpl {
 #else
     WindowImpl& me = *((WindowImpl*)param);
 #endif    
+    Screen& scr = *me.win->screen;
 
-    MEVENT ev;
+    input_event_t in_ev;
     win_event_t win_ev;
     int key;
 
     win_ev = WIN_EV_NONE;
-    key = me.getchar();
-
-    if (key == ERR) {
+    if (!scr.read_input(me.win, in_ev)) {
       return NULL;
     }
+    key = in_ev.key;
+    MEVENT& ev = in_ev.mouse;
 
     switch(key) {
-      case 9:
-        {
-          Screen::get_instance().set_focus_next(me.win);
-          break;
-        }
       case KEY_MOUSE:
         {
-          if (getmouse(&ev) == OK) {
-            win_ev = WIN_EV_MOUSE;
-            /* copy data */
-            me.ev_lookup[win_ev].cb_data = &ev;
-          }
+          win_ev = WIN_EV_MOUSE;
           break;
         }
       case KEY_RESIZE:
         {
-          if (me.was_resized == true) {
-            win_ev = WIN_EV_RESIZE;
-            me.ev_lookup[win_ev].cb_data = &me.resize_dim;
-          }
+          /* Windows are notified when the layout changes their geometry */
+          scr.request_layout();
           break;
         }
       default:
         {
-          if (me.textfield) {
-            /* Backspace needs special handling */
-            if (key == KEY_BACKSPACE) {
-              win_ev = WIN_EV_TERM;
-              me.ev_lookup[win_ev].cb_data = &key;
-              me.bksp();
-            }
-            /* Keyboard events */
-            else if ((key > 31) &&
-                (key < 127)) {
+          /* One index into the compiled table of the keymap, the first
+           * table unless the key continues a chord */
+          keymap_t& km = (me.keys != NULL) ? *me.keys : scr.get_keymap();
+          key_slot_t slot = km.lookup(me.chord, key);
+          me.chord = 0;
+
+          switch (slot.action) {
+            case ACTION_PREFIX:
+              me.chord = slot.arg;
+              break;
+            case ACTION_CALL:
+              km.call(slot.arg, KeyEvent(me.win, key));
+              break;
+            case ACTION_KEY:
+              win_ev = WIN_EV_KEY;
+              break;
+            case ACTION_SUBMIT:
               win_ev = WIN_EV_TERM;
-              me.ev_lookup[win_ev].cb_data = &key;
-
-              if (me.cur.x <= me.win_dim.w) {
-                if (key != 9) {
-                  me.addchar(key);
-                }
+              break;
+            case ACTION_FOCUS_NEXT:
+              scr.set_focus_next(me.win);
+              break;
+            case ACTION_FOCUS_PREV:
+              scr.set_focus_prev(me.win);
+              break;
+            default:
+              if (!me.textfield) {
+                break;
               }
-
-              if (key == 10) {
-                me.p_text_buf->newline();
-              }
-              else {
-                if (key != 9) {
-                  me.p_text_buf->put(key);
-                }
-              }
-
-              if (me.bordered == true) {
-                /* Enter/Return key */
-                if (key == 10) {
-                  if (me.cur.y < me.win_dim.h) {
-                    me.move_cur(++me.cur.y, 1);
-                  } else if (me.cur.y == me.win_dim.h) {
-                    me.move_cur(me.cur.y, --me.cur.x);
-                  }
-                  me.box();
-                }
-                else if (me.cur.x > me.win_dim.w) {
-                  if (me.cur.y < me.win_dim.h) {
-                    me.move_cur(++me.cur.y, 1);
+              switch (slot.action) {
+                case ACTION_INSERT:
+                  /* Keys breaking the constraints, and keys bound to insert
+                   * that are not printable ASCII, are dropped without an
+                   * event */
+                  if ((key < 32) || (key > 126) ||
+                      ((me.validator != NULL) && !me.validate(key))) {
+                    break;
                   }
-                  else if (me.cur.y == me.win_dim.h) {
-                    if (me.textfield) {
-                      me.p_text_buf->move_col_rel(-1);
-                    }
-                  }
-                }
+                  win_ev = WIN_EV_TERM;
+                  me.input(key);
+                  break;
+                case ACTION_NEWLINE:
+                  win_ev = WIN_EV_TERM;
+                  me.input(10);
+                  break;
+                case ACTION_BACKSPACE:
+                  win_ev = WIN_EV_TERM;
+                  me.bksp();
+                  break;
+                case ACTION_UNDO:
+                  win_ev = WIN_EV_TERM;
+                  me.undo();
+                  break;
+                case ACTION_REDO:
+                  win_ev = WIN_EV_TERM;
+                  me.redo();
+                  break;
+                case ACTION_CURSOR_LEFT:
+                case ACTION_CURSOR_RIGHT:
+                case ACTION_CURSOR_UP:
+                case ACTION_CURSOR_DOWN:
+                case ACTION_CURSOR_HOME:
+                case ACTION_CURSOR_END:
+                  win_ev = WIN_EV_KEY;
+                  me.move_text_cur(slot.action);
+                  break;
               }
-
-            }
-            /* Movement keys */
-            else if ((key >= KEY_DOWN) &&
-                (key < KEY_MOUSE)) {
-              win_ev = WIN_EV_KEY;
-              me.ev_lookup[win_ev].cb_data = &key;
-            }
-          } /* if (textfield) */
+          }
         }
     }
 
-    if (win_ev != WIN_EV_NONE) {
-      win_ev_entry_t ev_data = me.ev_lookup[win_ev];
-      if (ev_data.cb != NULL) {
-        ev_data.cb(ev_data.cb_data, ev_data.user_data);
-      }
+    switch (win_ev) {
+      case WIN_EV_KEY:
+      case WIN_EV_TERM:
+        {
+          KeyEvent key_ev(me.win, key);
+          scr.dispatch(win_ev, key_ev, &key);
+          break;
+        }
+      case WIN_EV_MOUSE:
+        {
+          /* Mouse events target the window under the pointer */
+          Window* target = scr.window_at(ev.y, ev.x);
+          MouseEvent mouse_ev((target != NULL) ? target : me.win, ev);
+          scr.dispatch(win_ev, mouse_ev, &ev);
+          break;
+        }
+      default:
+        break;
     }
 
     return NULL;
@@ -270,56 +654,1004 @@ class Window::WindowImpl {
     update_cb_data = NULL;
   }
 
-  void reg_event_handler(
-      win_event_t ev,
-      win_ev_cb_t cb,
-      win_ev_user_data_t user_data
-    ) {
+  void reg_event_handler(
+      win_event_t ev,
+      win_ev_cb_t cb,
+      win_ev_user_data_t user_data
+    ) {
+
+    ev_lookup[ev].cb = cb;
+    ev_lookup[ev].user_data = user_data;
+  }
+
+  void dereg_cb(win_event_t ev) {
+    ev_lookup[ev].cb = NULL;
+    ev_lookup[ev].user_data = NULL;
+  }
+
+  int subscribe(win_event_t ev, const raw_delegate& handler, bool capture) {
+    win_ev_handler_t entry;
+    entry.id = next_handler_id++;
+    entry.capture = capture;
+    entry.handler = handler;
+    ev_lookup[ev].handlers.push_back(entry);
+    return entry.id;
+  }
+
+  void unsubscribe(int id) {
+    for (int i = 0; i < WIN_EV_MAX; i++) {
+      std::vector<win_ev_handler_t>& handlers = ev_lookup[i].handlers;
+      for (std::size_t j = 0; j < handlers.size(); j++) {
+        if (handlers[j].id == id) {
+          /* Handlers being dispatched are removed once the dispatch is
+           * over */
+          if (dispatch_depth > 0) {
+            handlers[j].id = 0;
+            handlers_removed = true;
+          } else {
+            handlers.erase(handlers.begin() + j);
+          }
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Call the handlers subscribed to an event for the phase of the
+   * dispatch. The callback registered with reg_event_handler is called first,
+   * at the target and during the bubble phase.
+   * @param ev The window event.
+   * @param e The typed event.
+   * @param cb_data The data passed to the registered callback.
+   */
+  void notify(win_event_t ev, const Event& e, win_ev_cb_data_t cb_data) {
+    win_ev_entry_t& entry = ev_lookup[ev];
+
+    if ((entry.cb != NULL) && (e.phase != EV_PHASE_CAPTURE)) {
+      entry.cb(cb_data, entry.user_data);
+    }
+
+    ++dispatch_depth;
+    /* Handlers subscribed during the dispatch are not called */
+    std::size_t count = entry.handlers.size();
+    for (std::size_t i = 0; i < count; i++) {
+      const win_ev_handler_t& h = entry.handlers[i];
+      if ((h.id != 0) &&
+          ((e.phase == EV_PHASE_TARGET) ||
+           (h.capture == (e.phase == EV_PHASE_CAPTURE)))) {
+        raw_delegate handler = h.handler;
+        handler.invoke(&e);
+      }
+    }
+    --dispatch_depth;
+
+    if ((dispatch_depth == 0) && handlers_removed) {
+      handlers_removed = false;
+      for (int i = 0; i < WIN_EV_MAX; i++) {
+        std::vector<win_ev_handler_t>& handlers = ev_lookup[i].handlers;
+        for (std::size_t j = handlers.size(); j > 0; j--) {
+          if (handlers[j - 1].id == 0) {
+            handlers.erase(handlers.begin() + (j - 1));
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Build the cells of the border for the size of the window.
+   */
+  void build_border() {
+    int w = getmaxx(win_handle);
+    chtype a = border_attrs;
+
+    chtype hline = ACS_HLINE, vline = ACS_VLINE;
+    chtype corners[4] = { ACS_ULCORNER, ACS_URCORNER, ACS_LLCORNER,
+      ACS_LRCORNER };
+    if (border_kind == BORDER_ASCII) {
+      hline = '-';
+      vline = '|';
+      std::fill(corners, corners + 4, (chtype)'+');
+    } else if (border_kind == BORDER_INVISIBLE) {
+      hline = vline = ' ';
+      std::fill(corners, corners + 4, (chtype)' ');
+    }
+
+    border_top.assign(w, hline | a);
+    border_bottom.assign(w, hline | a);
+    border_top[0] = corners[0] | a;
+    border_top[w - 1] = corners[1] | a;
+    border_bottom[0] = corners[2] | a;
+    border_bottom[w - 1] = corners[3] | a;
+    border_side[0] = border_side[1] = vline | a;
+
+    /* The title is set in the top border, between spaces */
+    int room = std::min((int)title.size(), w - 6);
+    if (room > 0) {
+      border_top[2] = ' ' | a;
+      for (int i = 0; i < room; i++) {
+        border_top[3 + i] = (unsigned char)title[i] | a;
+      }
+      border_top[3 + room] = ' ' | a;
+    }
+    border_built = true;
+  }
+
+  /**
+   * @brief Check whether the border shows its cells.
+   * @return true if none of them were overwritten, false otherwise.
+   */
+  bool border_intact() {
+    int h, w;
+    getmaxyx(win_handle, h, w);
+    if (!border_built || ((int)border_top.size() != w)) {
+      return false;
+    }
+
+    std::vector<chtype> row(w + 1);
+    mvwinchnstr(win_handle, 0, 0, row.data(), w);
+    bool intact = std::equal(border_top.begin(), border_top.end(),
+        row.begin());
+    if (intact) {
+      mvwinchnstr(win_handle, h - 1, 0, row.data(), w);
+      intact = std::equal(border_bottom.begin(), border_bottom.end(),
+          row.begin());
+    }
+    for (int y = 1; intact && (y < h - 1); y++) {
+      intact = (mvwinch(win_handle, y, 0) == border_side[0]) &&
+        (mvwinch(win_handle, y, w - 1) == border_side[1]);
+    }
+    wmove(win_handle, cur.y, cur.x);
+    return intact;
+  }
+
+  void box() {
+    if (win_handle == NULL) {
+      return;
+    }
+    if (!border_built || ((int)border_top.size() != getmaxx(win_handle))) {
+      build_border();
+    }
+
+    int h = getmaxy(win_handle);
+    int w = (int)border_top.size();
+    mvwaddchnstr(win_handle, 0, 0, border_top.data(), w);
+    mvwaddchnstr(win_handle, h - 1, 0, border_bottom.data(), w);
+    for (int y = 1; y < h - 1; y++) {
+      mvwaddchnstr(win_handle, y, 0, &border_side[0], 1);
+      mvwaddchnstr(win_handle, y, w - 1, &border_side[1], 1);
+    }
+    wmove(win_handle, cur.y, cur.x);
+    dirty = true;
+  }
+
+  void set_background(style_id_t style) {
+    attr_t attrs;
+    short pair;
+    if (!win->screen->resolve_style(style, attrs, pair, true)) {
+      return;
+    }
+    win->screen->unpin_style(bg_style);
+    bg_style = style;
+    bg_attrs = ' ' | attrs | COLOR_PAIR(pair);
+    if (win_handle != NULL) {
+      wbkgd(win_handle, bg_attrs);
+      dirty = true;
+    }
+  }
+
+  void set_border_style(style_id_t style) {
+    attr_t attrs;
+    short pair;
+    if (!win->screen->resolve_style(style, attrs, pair, true)) {
+      return;
+    }
+    win->screen->unpin_style(border_style);
+    border_style = style;
+    border_attrs = attrs | COLOR_PAIR(pair);
+    border_built = false;
+    restore_border();
+  }
+
+  void set_border(border_t kind) {
+    if (border_kind != kind) {
+      border_kind = kind;
+      border_built = false;
+      restore_border();
+    }
+  }
+
+  void set_title(const std::string& str) {
+    if (title != str) {
+      title = str;
+      border_built = false;
+      restore_border();
+    }
+  }
+
+  /**
+   * @brief Write the cells of the border if they were overwritten or
+   * changed, the window is not drawn again otherwise.
+   */
+  void restore_border() {
+    if (bordered && (win_handle != NULL) && !border_intact()) {
+      box();
+    }
+  }
+
+  void set_layout(layout_dir_t dir) {
+    layout_dir = dir;
+  }
+
+  layout_dir_t get_layout() {
+    return layout_dir;
+  }
+
+  void set_size(size_spec_t h, size_spec_t w) {
+    h_spec = h;
+    w_spec = w;
+    managed = true;
+  }
+
+  bool is_managed() {
+    return managed;
+  }
+
+  void get_size(size_spec_t& h, size_spec_t& w) {
+    h = h_spec;
+    w = w_spec;
+  }
+
+  bool needs_layout() {
+    return layout_dirty;
+  }
+
+  void set_layout_dirty(bool flag) {
+    layout_dirty = flag;
+  }
+
+  void get_content_area(int& h, int& w, int& y, int& x) {
+    int inset = (bordered) ? 1 : 0;
+    h = outer_dim.h - 2 * inset;
+    w = outer_dim.w - 2 * inset;
+    y = x = inset;
+  }
+
+  bool geometry_changed(int h, int w, int y, int x) {
+    /* Derived windows are placed relative to the parent */
+    int abs_y = y;
+    int abs_x = x;
+    if (parent_win_handle) {
+      abs_y += getbegy(parent_win_handle);
+      abs_x += getbegx(parent_win_handle);
+    }
+
+    return (!layout_valid) ||
+      (std::max(h, 1) != outer_dim.h) || (std::max(w, 1) != outer_dim.w) ||
+      (y != win_coord.y) || (x != win_coord.x) ||
+      ((win_handle != NULL) &&
+       ((abs_y != getbegy(win_handle)) || (abs_x != getbegx(win_handle))));
+  }
+
+  void vacate() {
+    if (win_handle != NULL) {
+      werase(win_handle);
+    }
+  }
+
+  /**
+   * @brief Keep the geometry of a window that is not realized, it is applied
+   * when the window is created.
+   */
+  void store_geometry(int h, int w, int y, int x) {
+    outer_dim.h = h;
+    outer_dim.w = w;
+    win_coord.y = y;
+    win_coord.x = x;
+    win_dim = outer_dim;
+    if (bordered) {
+      win_dim.h -= 2;
+      win_dim.w -= 2;
+    }
+
+    if (p_text_buf != NULL) {
+      field_buf_t* p_old = p_text_buf;
+      p_text_buf = new_text_buf();
+      p_text_buf->copy_from(*p_old);
+      val_row = -1;
+      delete p_old;
+    }
+  }
+
+  bool set_geometry(int h, int w, int y, int x, bool force) {
+    bool changed = geometry_changed(h, w, y, x);
+    if (!changed && !force) {
+      return false;
+    }
+    layout_valid = true;
+
+    if (h < 1) {
+      h = 1;
+    }
+    if (w < 1) {
+      w = 1;
+    }
+
+    if (win_handle == NULL) {
+      store_geometry(h, w, y, x);
+      return true;
+    }
+
+    int abs_y = y;
+    int abs_x = x;
+    if (parent_win_handle) {
+      abs_y += getbegy(parent_win_handle);
+      abs_x += getbegx(parent_win_handle);
+    }
+
+    if (changed) {
+      /* Shrink first so that the move fits in the parent and the screen */
+      wresize(win_handle, 1, 1);
+      if (parent_win_handle) {
+        mvderwin(win_handle, y, x);
+      }
+      mvwin(win_handle, abs_y, abs_x);
+      wresize(win_handle, h, w);
+    }
+
+    werase(win_handle);
+
+    outer_dim.h = h;
+    outer_dim.w = w;
+    win_coord.y = y;
+    win_coord.x = x;
+    getmaxyx(win_handle, win_dim.h, win_dim.w);
+    if (bordered) {
+      win_dim.h -= 2;
+      win_dim.w -= 2;
+    }
+
+    restore_border();
+
+    if (pad != NULL) {
+      scroll_to(pad_top, pad_left, true);
+    }
+
+    if (textfield) {
+      field_buf_t* p_old = p_text_buf;
+      p_text_buf = new_text_buf();
+      p_text_buf->copy_from(*p_old);
+      val_row = -1;
+      delete p_old;
+      repaint_text();
+    } else {
+      move_cur(0, 0);
+    }
+
+    resize_dim = win_dim;
+    ResizeEvent resize_ev(win, win_dim.h, win_dim.w);
+    notify(WIN_EV_RESIZE, resize_ev, &resize_dim);
+
+    dirty = true;
+    return true;
+  }
+
+  void repaint_text() {
+    int inset = (bordered) ? 1 : 0;
+    for (int i = 0; i < p_text_buf->num_rows; i++) {
+      line_buf_t* line = p_text_buf->rows[i];
+      mvwaddnstr(win_handle, i + inset, inset, line->str,
+          strnlen(line->str, line->len));
+    }
+    move_cur(p_text_buf->idx + inset,
+        p_text_buf->rows[p_text_buf->idx]->idx + inset);
+  }
+
+  text_view_t text() {
+    return text_view_t(p_text_buf);
+  }
+
+  bool set_text(const char* text, std::size_t len) {
+    if (!textfield) {
+      return false;
+    }
+    if (p_text_buf == NULL) {
+      p_text_buf = new_text_buf();
+    }
+    p_text_buf->assign(text, len);
+    reprint_text();
+    return true;
+  }
+
+  /**
+   * @brief Blank the rows of a textfield and print its text again once
+   * changed other than by typing. Realizing the window prints it otherwise.
+   */
+  void reprint_text() {
+    val_row = -1;
+    if (win_handle != NULL) {
+      int inset = (bordered) ? 1 : 0;
+      for (int i = 0; i < p_text_buf->num_rows; i++) {
+        mvwhline(win_handle, i + inset, inset, ' ', p_text_buf->num_cols);
+      }
+      repaint_text();
+    }
+  }
+
+  bool undo() {
+    if ((p_text_buf == NULL) || !p_text_buf->undo()) {
+      return false;
+    }
+    reprint_text();
+    return true;
+  }
+
+  bool redo() {
+    if ((p_text_buf == NULL) || !p_text_buf->redo()) {
+      return false;
+    }
+    reprint_text();
+    return true;
+  }
+
+  keymap_t& get_keymap() {
+    if (keys == NULL) {
+      keys = new keymap_t(&win->screen->get_keymap());
+    }
+    return *keys;
+  }
+
+  /**
+   * @brief Move the cursor of a textfield in its text, the cursor on the
+   * screen follows it. The cursor does not move past the end of the text of
+   * a row.
+   * @param action One of the ACTION_CURSOR_* actions.
+   */
+  void move_text_cur(int action) {
+    if ((p_text_buf == NULL) || (win_handle == NULL)) {
+      return;
+    }
+    field_buf_t& buf = *p_text_buf;
+    int col = buf.rows[buf.idx]->idx;
+
+    switch (action) {
+      case ACTION_CURSOR_LEFT:
+        buf.move_col_rel(-1);
+        break;
+      case ACTION_CURSOR_RIGHT:
+        if (col < buf.rows[buf.idx]->length()) {
+          buf.move_col_rel(1);
+        }
+        break;
+      case ACTION_CURSOR_UP:
+      case ACTION_CURSOR_DOWN:
+        buf.move_row_rel((action == ACTION_CURSOR_UP) ? -1 : 1);
+        buf.move_col(std::min(col, buf.rows[buf.idx]->length()));
+        break;
+      case ACTION_CURSOR_HOME:
+        buf.move_col(0);
+        break;
+      case ACTION_CURSOR_END:
+        buf.move_col(buf.rows[buf.idx]->length());
+        break;
+    }
+
+    int inset = (bordered) ? 1 : 0;
+    move_cur(buf.idx + inset, buf.rows[buf.idx]->idx + inset);
+  }
+
+  void set_undo_limit(int edits) {
+    undo_limit = std::max(edits, 0);
+    if (p_text_buf != NULL) {
+      p_text_buf->set_journal_cap(undo_limit);
+    }
+  }
+
+  field_buf_t* new_text_buf() {
+    return new field_buf_t(std::max(win_dim.h, 1), std::max(win_dim.w, 1),
+        undo_limit);
+  }
+
+  void print(int y, int x, std::string str) {
+    if (pad != NULL) {
+      print_pad(y, x, str.c_str(), str.length());
+      return;
+    }
+
+    /* Windows print their content when they are realized */
+    if (!textfield && (win_handle != NULL)) {
+
+      if (!bordered) {
+        mvwprintw(win_handle, y, x, "%s", str.c_str());
+
+      } else {
+        int height = win_dim.h;
+        std::size_t len = str.length();
+        std::size_t pos = 0;
+
+        if (bordered) {
+          y++, x++;
+        }
+
+        bool first_line = true;
+        while (len && y <= height) {
+          std::size_t count = win_dim.w - (x - 1);
+          std::string tmp = str.substr(pos, count);
+          count = tmp.length();
+          mvwprintw(win_handle, y++, x, "%s", tmp.c_str());
+          len -= count;
+          pos += count;
+          if (first_line) {
+            x = (bordered) ? 1: 0;
+            first_line = false;
+          }
+        }
+      }
+
+      dirty = true;
+    }
+  }
+
+  void print(int y, int x, std::string str, style_id_t style) {
+    attr_t attrs;
+    short pair;
+    if (textfield || !win->screen->resolve_style(style, attrs, pair)) {
+      return;
+    }
+
+    WINDOW* canvas = (pad != NULL) ? pad : win_handle;
+    if (canvas == NULL) {
+      return;
+    }
+    attr_t old_attrs;
+    short old_pair;
+    wattr_get(canvas, &old_attrs, &old_pair, NULL);
+    wattr_set(canvas, attrs, pair, NULL);
+    print(y, x, str);
+    wattr_set(canvas, old_attrs, old_pair, NULL);
+  }
+
+  bool set_scrollable(int rows, int cols) {
+    if (textfield) {
+      return false;
+    }
+
+    WINDOW* p_pad = newpad(std::max(rows, 1), std::max(cols, 1));
+    if (p_pad == NULL) {
+      return false;
+    }
+
+    /* Keep the content that fits when the pad is resized */
+    if (pad != NULL) {
+      int old_rows, old_cols;
+      getmaxyx(pad, old_rows, old_cols);
+      copywin(pad, p_pad, 0, 0, 0, 0,
+          std::min(old_rows, std::max(rows, 1)) - 1,
+          std::min(old_cols, std::max(cols, 1)) - 1, FALSE);
+      delwin(pad);
+    }
+
+    pad = p_pad;
+    scroll_to(pad_top, pad_left, true);
+    return true;
+  }
+
+  void scroll_to(int top, int left, bool force = false) {
+    if (pad == NULL) {
+      return;
+    }
+
+    int rows, cols;
+    getmaxyx(pad, rows, cols);
+    top = std::max(std::min(top, rows - win_dim.h), 0);
+    left = std::max(std::min(left, cols - win_dim.w), 0);
+
+    if ((top != pad_top) || (left != pad_left) || force) {
+      pad_top = top;
+      pad_left = left;
+      view_stale = true;
+      dirty = true;
+    }
+  }
+
+  void get_scroll(int& top, int& left) {
+    top = pad_top;
+    left = pad_left;
+  }
+
+  /**
+   * @brief Copy the visible part of the content into the window.
+   */
+  void sync_view() {
+    view_stale = false;
+
+    int inset = (bordered) ? 1 : 0;
+    int rows, cols;
+    getmaxyx(pad, rows, cols);
+    int h = std::min(win_dim.h, rows - pad_top);
+    int w = std::min(win_dim.w, cols - pad_left);
+
+    if ((h > 0) && (w > 0)) {
+      copywin(pad, win_handle, pad_top, pad_left, inset, inset,
+          inset + h - 1, inset + w - 1, FALSE);
+    }
+
+    /* The viewport may be larger than the content */
+    for (int y = inset; y < inset + win_dim.h; y++) {
+      int from = (y < inset + h) ? std::max(w, 0) : 0;
+      if (from < win_dim.w) {
+        mvwhline(win_handle, y, inset + from, ' ', win_dim.w - from);
+      }
+    }
+
+    /* Only the matches in the viewport are highlighted */
+    if (!find_levels.empty() && (h > 0) && (w > 0)) {
+      const std::vector<uint32_t>& hits = find_levels.back().hits;
+      int len = (int)find_query.size();
+      std::vector<uint32_t>::const_iterator it = std::lower_bound(
+          hits.begin(), hits.end(), (uint32_t)(pad_top * find_stride));
+      uint32_t end = (uint32_t)((pad_top + h) * find_stride);
+      for (; (it != hits.end()) && (*it < end); ++it) {
+        int row = *it / find_stride;
+        int col = *it % find_stride;
+        int from = std::max(col, pad_left);
+        int to = std::min(col + len, pad_left + w);
+        if (from < to) {
+          highlight(inset + row - pad_top, inset + from - pad_left, to - from,
+              (it - hits.begin()) == find_cur);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Highlight cells of a match.
+   * @param y The row of the window.
+   * @param x The column of the window.
+   * @param n The number of cells.
+   * @param current Whether the match is the current one.
+   */
+  void highlight(int y, int x, int n, bool current) {
+    attr_t attrs = A_REVERSE;
+    short pair = 0;
+    style_id_t style = (current) ? find_cur_style : find_style;
+    if (style != 0) {
+      win->screen->resolve_style(style, attrs, pair);
+    } else if (current) {
+      attrs |= A_BOLD;
+    }
+    mvwchgat(win_handle, y, x, n, attrs, pair, NULL);
+  }
+
+  /**
+   * @brief Read the text searched into find_text, one row at a time.
+   * @param[out] changed The rows that changed since the last search.
+   * @return false if the text was read again as a whole, true otherwise.
+   */
+  bool read_find_text(std::vector<int>& changed) {
+    int rows = 0, cols = 0, inset = 0;
+    WINDOW* src = NULL;
+    if (p_text_buf != NULL) {
+      rows = p_text_buf->num_rows;
+      cols = p_text_buf->num_cols;
+    } else if (pad != NULL) {
+      src = pad;
+      getmaxyx(pad, rows, cols);
+    } else if (win_handle != NULL) {
+      src = win_handle;
+      rows = win_dim.h;
+      cols = win_dim.w;
+      inset = (bordered) ? 1 : 0;
+    }
+
+    bool kept = (cols == find_stride) &&
+      (find_text.size() == (std::size_t)rows * cols);
+    if (!kept) {
+      find_text.assign((std::size_t)rows * cols, ' ');
+      find_stride = cols;
+    }
+
+    std::vector<char> line(cols + 1);
+    for (int row = 0; row < rows; row++) {
+      /* Rows of a pad not written since they were read are skipped, pads
+       * are never refreshed so nothing else clears the flags */
+      if (kept && (src == pad) && (pad != NULL) &&
+          !is_linetouched(pad, row)) {
+        continue;
+      }
+
+      int n = 0;
+      if (p_text_buf != NULL) {
+        n = p_text_buf->rows[row]->length();
+        memcpy(line.data(), p_text_buf->rows[row]->str, n);
+      } else {
+        n = std::max(mvwinnstr(src, row + inset, inset, line.data(), cols), 0);
+      }
+      memset(line.data() + n, ' ', cols - n);
+
+      char* dst = &find_text[(std::size_t)row * cols];
+      if (memcmp(dst, line.data(), cols) != 0) {
+        memcpy(dst, line.data(), cols);
+        changed.push_back(row);
+      }
+    }
+
+    if ((pad != NULL) && (src == pad)) {
+      wtouchln(pad, 0, rows, 0);
+    } else if (win_handle != NULL) {
+      wmove(win_handle, cur.y, cur.x);
+    }
+    return kept;
+  }
+
+  /**
+   * @brief Find the matches of the query in some rows of the text.
+   * @param from The first row.
+   * @param to The row after the last one.
+   * @param[out] hits The positions of the matches, in order.
+   */
+  void scan(int from, int to, std::vector<uint32_t>& hits) {
+    const char* text = find_text.data();
+    const char* needle = find_query.data();
+    std::size_t len = find_query.size();
+    const char* p = text + (std::size_t)from * find_stride;
+    const char* end = text + (std::size_t)to * find_stride;
+
+    while ((std::size_t)(end - p) >= len) {
+      /* memchr skips to the first byte of a single character query, memmem
+       * runs the two-way algorithm of the C library otherwise */
+      const char* hit = (const char*)((len == 1) ?
+          memchr(p, needle[0], end - p) : memmem(p, end - p, needle, len));
+      if (hit == NULL) {
+        break;
+      }
+      std::size_t pos = hit - text;
+      if ((pos % find_stride) + len <= (std::size_t)find_stride) {
+        hits.push_back((uint32_t)pos);
+      }
+      p = hit + 1;
+    }
+  }
+
+  /**
+   * @brief Put back the cells highlighted in a window that is not
+   * scrollable, unless something was printed over them.
+   */
+  void unhighlight() {
+    for (std::size_t i = 0; i < find_cells.size(); i++) {
+      const find_cell_t& cell = find_cells[i];
+      if (mvwinch(win_handle, cell.y, cell.x) == cell.shown) {
+        mvwaddch(win_handle, cell.y, cell.x, cell.orig);
+      }
+    }
+    find_cells.clear();
+  }
+
+  /**
+   * @brief Update the highlighted matches once they changed.
+   */
+  void show_matches() {
+    dirty = true;
+    if (pad != NULL) {
+      view_stale = true;
+      return;
+    }
+    if (win_handle == NULL) {
+      find_cells.clear();
+      return;
+    }
+
+    unhighlight();
+    if (!find_levels.empty()) {
+      const std::vector<uint32_t>& hits = find_levels.back().hits;
+      int inset = (bordered) ? 1 : 0;
+      int len = (int)find_query.size();
+      for (std::size_t i = 0; i < hits.size(); i++) {
+        int y = inset + hits[i] / find_stride;
+        int x = inset + hits[i] % find_stride;
+        for (int j = 0; j < len; j++) {
+          find_cell_t cell = { y, x + j, mvwinch(win_handle, y, x + j), 0 };
+          find_cells.push_back(cell);
+        }
+        highlight(y, x, len, (int)i == find_cur);
+        for (int j = 0; j < len; j++) {
+          find_cells[find_cells.size() - len + j].shown =
+            mvwinch(win_handle, y, x + j);
+        }
+      }
+    }
+    wmove(win_handle, cur.y, cur.x);
+  }
+
+  int find(const std::string& query) {
+    std::vector<int> changed;
+    bool kept = read_find_text(changed);
+
+    /* Matches of the prefix the query shares with the last one are kept */
+    std::size_t common = 0;
+    while ((common < query.size()) && (common < find_query.size()) &&
+        (query[common] == find_query[common])) {
+      ++common;
+    }
+    if (!kept) {
+      find_levels.clear();
+    }
+    while (!find_levels.empty() && (find_levels.back().len > common)) {
+      find_levels.pop_back();
+    }
+
+    /* Rows that changed are searched again for the longest prefix kept, the
+     * shorter ones are dropped */
+    if (!changed.empty() && !find_levels.empty()) {
+      find_level_t& top = find_levels.back();
+      find_query.assign(query, 0, top.len);
+      std::vector<uint32_t> hits;
+      std::size_t i = 0;
+      for (std::size_t c = 0; c < changed.size(); c++) {
+        uint32_t from = (uint32_t)(changed[c] * find_stride);
+        uint32_t to = from + find_stride;
+        for (; (i < top.hits.size()) && (top.hits[i] < from); i++) {
+          hits.push_back(top.hits[i]);
+        }
+        for (; (i < top.hits.size()) && (top.hits[i] < to); i++);
+        scan(changed[c], changed[c] + 1, hits);
+      }
+      hits.insert(hits.end(), top.hits.begin() + i, top.hits.end());
+      top.hits.swap(hits);
+      find_levels.erase(find_levels.begin(), find_levels.end() - 1);
+    }
 
-    ev_lookup[ev].cb = cb;
-    ev_lookup[ev].user_data = user_data;
+    find_query = query;
+    find_cur = -1;
+    if (query.empty()) {
+      find_levels.clear();
+    } else if (find_levels.empty()) {
+      find_level_t level;
+      level.len = query.size();
+      find_levels.push_back(level);
+      scan(0, (int)(find_text.size() / std::max(find_stride, 1)),
+          find_levels.back().hits);
+    } else if (find_levels.back().len < query.size()) {
+      /* The matches of a longer query are among those of its prefix */
+      const find_level_t& prev = find_levels.back();
+      find_level_t level;
+      level.len = query.size();
+      std::size_t len = query.size();
+      for (std::size_t i = 0; i < prev.hits.size(); i++) {
+        uint32_t pos = prev.hits[i];
+        if (((pos % find_stride) + len <= (std::size_t)find_stride) &&
+            (memcmp(&find_text[pos + prev.len], query.data() + prev.len,
+                    len - prev.len) == 0)) {
+          level.hits.push_back(pos);
+        }
+      }
+      find_levels.push_back(level);
+    }
+
+    show_matches();
+    return find_levels.empty() ? 0 : (int)find_levels.back().hits.size();
   }
 
-  void dereg_cb(win_event_t ev) {
-    ev_lookup[ev].cb = NULL;
-    ev_lookup[ev].user_data = NULL;
+  bool find_next(bool forward, int& row, int& col) {
+    if (find_levels.empty() || find_levels.back().hits.empty()) {
+      return false;
+    }
+    const std::vector<uint32_t>& hits = find_levels.back().hits;
+    int n = (int)hits.size();
+
+    if (find_cur < 0) {
+      /* Start from the first match in the viewport */
+      uint32_t top = (uint32_t)(pad_top * find_stride);
+      find_cur = (int)(std::lower_bound(hits.begin(), hits.end(), top) -
+          hits.begin());
+      if (!forward) {
+        --find_cur;
+      }
+    } else {
+      find_cur += (forward) ? 1 : -1;
+    }
+    find_cur = ((find_cur % n) + n) % n;
+
+    row = hits[find_cur] / find_stride;
+    col = hits[find_cur] % find_stride;
+    if ((pad != NULL) && ((row < pad_top) || (row >= pad_top + win_dim.h) ||
+          (col < pad_left) ||
+          (col + (int)find_query.size() > pad_left + win_dim.w))) {
+      scroll_to(row - (win_dim.h / 2), col - (win_dim.w / 2));
+    }
+    show_matches();
+    return true;
   }
 
-  void box() {
-    ::box(win_handle, 0, 0);
-    dirty = true;
+  void set_find_styles(style_id_t match, style_id_t current) {
+    find_style = match;
+    find_cur_style = current;
+    if (!find_levels.empty()) {
+      show_matches();
+    }
   }
 
-  void print(int y, int x, std::string str) {
-    if (!textfield) {
+  void print_pad(int y, int x, const char* text, int len) {
+    int rows, cols;
+    getmaxyx(pad, rows, cols);
+    if ((y < 0) || (y >= rows) || (x < 0) || (x >= cols)) {
+      return;
+    }
 
-      if (!bordered) {
-        mvwprintw(win_handle, y, x, "%s", str.c_str());
+    mvwaddnstr(pad, y, x, text, std::min(len, cols - x));
 
-      } else {
-        int height = win_dim.h;
-        std::size_t len = str.length();
-        std::size_t pos = 0;
+    /* Content outside the viewport is copied when scrolled into it */
+    if ((y >= pad_top) && (y < pad_top + win_dim.h)) {
+      view_stale = true;
+      dirty = true;
+    }
+  }
 
-        if (bordered) {
-          y++, x++;
-        }
+  void print(int y, int x, const styled_span_t* spans, std::size_t count) {
+    if (textfield || ((pad == NULL) && (win_handle == NULL))) {
+      return;
+    }
 
-        bool first_line = true;
-        while (len && y <= height) {
-          std::size_t count = win_dim.w - (x - 1);
-          std::string tmp = str.substr(pos, count);
-          count = tmp.length();
-          mvwprintw(win_handle, y++, x, "%s", tmp.c_str());
-          len -= count;
-          pos += count;
-          if (first_line) {
-            x = (bordered) ? 1: 0;
-            first_line = false;
+    /* Content of a scrollable window is not inset by the border */
+    WINDOW* canvas = win_handle;
+    int right = win_dim.w;
+    int bottom = win_dim.h - 1;
+    if (pad != NULL) {
+      canvas = pad;
+      getmaxyx(pad, bottom, right);
+      --bottom;
+    } else if (bordered) {
+      y++, x++;
+      right++;
+      bottom++;
+    }
+    if ((y < 0) || (y > bottom) || (x < 0) || (x >= right)) {
+      return;
+    }
+
+    attr_t old_attrs;
+    short old_pair;
+    wattr_get(canvas, &old_attrs, &old_pair, NULL);
+
+    std::size_t i = 0;
+    while ((i < count) && (x < right)) {
+      style_id_t style = spans[i].style;
+      const char* text = spans[i].text;
+      int len = (spans[i].len < 0) ? strlen(text) : spans[i].len;
+
+      /* Adjacent spans of the same style are written as one run */
+      if ((i + 1 < count) && (spans[i + 1].style == style)) {
+        run_buf.assign(text, len);
+        for (++i; (i < count) && (spans[i].style == style); i++) {
+          if (spans[i].len < 0) {
+            run_buf.append(spans[i].text);
+          } else {
+            run_buf.append(spans[i].text, spans[i].len);
           }
         }
+        text = run_buf.data();
+        len = run_buf.size();
+      } else {
+        ++i;
+      }
+
+      len = std::min(len, right - x);
+      attr_t attrs;
+      short pair;
+      if ((len > 0) &&
+          win->screen->resolve_style(style, attrs, pair)) {
+        wattr_set(canvas, attrs, pair, NULL);
+        mvwaddnstr(canvas, y, x, text, len);
       }
+      x += len;
+    }
 
+    wattr_set(canvas, old_attrs, old_pair, NULL);
+    if (pad == NULL) {
+      dirty = true;
+    } else if ((y >= pad_top) && (y < pad_top + win_dim.h)) {
+      view_stale = true;
       dirty = true;
     }
   }
@@ -327,8 +1659,10 @@ class Window::WindowImpl {
   void move(int y, int x) {
     win_coord.y = y;
     win_coord.x = x;
-    mvwin(win_handle, win_coord.y, win_coord.x);
-    dirty = true;
+    if (win_handle != NULL) {
+      mvwin(win_handle, win_coord.y, win_coord.x);
+      dirty = true;
+    }
   }
 
   void move_cur(int y, int x) {
@@ -356,7 +1690,9 @@ class Window::WindowImpl {
       x = win_dim.w;
     }
 
-    wmove(win_handle, y, x);
+    if (win_handle != NULL) {
+      wmove(win_handle, y, x);
+    }
 
     cur.y = y;
     cur.x = x;
@@ -392,36 +1728,69 @@ class Window::WindowImpl {
       cur.x = win_dim.w;
     }
 
-    wmove(win_handle, cur.y, cur.x);
+    if (win_handle != NULL) {
+      wmove(win_handle, cur.y, cur.x);
+    }
 
     dirty = true;
   }
 
   void get_cur(int& y, int& x) {
+    if (win_handle == NULL) {
+      y = cur.y;
+      x = cur.x;
+      return;
+    }
     getyx(win_handle, y, x);
   }
 
   void clear() {
+    if (win_handle == NULL) {
+      return;
+    }
     wclear(win_handle);
     if (bordered) {
+      box();
       move_cur(1, 1);
     } else {
       move_cur(0, 0);
     }
   }
 
-  void draw() {
+  /**
+   * @brief Draw the window, leaving out the lines covered by windows above
+   * it.
+   * @param flush Boolean flag specifying whether to output the window to
+   * the terminal or only copy it to the virtual screen of ncurses.
+   */
+  void draw(bool flush = true) {
     //if (bordered == TRUE) {
     //  box();
     //}
+    if ((win_handle == NULL) || !is_shown()) {
+      return;
+    }
+    if (view_stale) {
+      sync_view();
+    }
     dirty = false;
     if (parent_win_handle) {
       touchwin(parent_win_handle);
     }
-    wrefresh(win_handle);
+    win->screen->cull(win);
+    if (flush) {
+      wrefresh(win_handle);
+    } else {
+      wnoutrefresh(win_handle);
+    }
   }
 
-  void update() {
+  bool update(bool flush = true) {
+    /* Windows shown since the last frame are realized on their first draw */
+    if (!is_shown() || !realize()) {
+      return false;
+    }
+
     if (has_focus) {
       if(update_cb != NULL) {
         update_cb(update_cb_data);
@@ -429,30 +1798,40 @@ class Window::WindowImpl {
     }
 
     if (dirty) {
-      draw();
+      draw(flush);
+      return true;
     }
+    return false;
   }
 
   int getchar() {
+    if (win_handle == NULL) {
+      return ERR;
+    }
     return wgetch(win_handle);
   }
 
   int addchar(char c) {
+    if (win_handle == NULL) {
+      return ERR;
+    }
     dirty = true;
     ++cur.x;
     return waddch(win_handle, c);
   }
 
   void bksp() {
-    if (((bordered == true) && (cur.x > 1)) &&
-        (cur.x > 0)) {
+    if (win_handle == NULL) {
+      return;
+    }
+    int inset = (bordered) ? 1 : 0;
+    if (cur.x > inset) {
       mvwaddch(win_handle, cur.y, --cur.x, ' ');
       wmove(win_handle, cur.y, cur.x);
       dirty = true;
     }
-    else if ((bordered == true && cur.y > 1) &&
-             cur.y > 0) {
-      cur.x = win_dim.w;
+    else if (cur.y > inset) {
+      cur.x = win_dim.w - 1 + inset;
       mvwaddch(win_handle, --cur.y, cur.x, ' ');
       wmove(win_handle, cur.y, cur.x);
       dirty = true;
@@ -478,14 +1857,152 @@ class Window::WindowImpl {
   }
 
   bool enclose(int y, int x) {
+    if ((win_handle == NULL) || !is_shown()) {
+      return false;
+    }
     return (wenclose(win_handle, y, x) == TRUE) ? true : false;
   }
+
+  win_snapshot_t* snapshot(bool cells) {
+    win_snapshot_t* snap = new win_snapshot_t;
+    snap->cells = NULL;
+    snap->cur_y = cur.y;
+    snap->cur_x = cur.x;
+    snap->text = NULL;
+
+    if (cells && (win_handle != NULL)) {
+      int h = getmaxy(win_handle);
+      int w = getmaxx(win_handle);
+      snap->cells = newpad(h, w);
+      if (snap->cells != NULL) {
+        copywin(win_handle, snap->cells, 0, 0, 0, 0, h - 1, w - 1, FALSE);
+      }
+    }
+
+    if (p_text_buf != NULL) {
+      snap->text = new field_buf_t(p_text_buf->num_rows, p_text_buf->num_cols);
+      snap->text->copy_from(*p_text_buf);
+    }
+
+    return snap;
+  }
+
+  void restore(const win_snapshot_t* snap) {
+    if ((snap->cells != NULL) && (win_handle != NULL)) {
+      int h = std::min(getmaxy(win_handle), getmaxy(snap->cells));
+      int w = std::min(getmaxx(win_handle), getmaxx(snap->cells));
+      copywin(snap->cells, win_handle, 0, 0, 0, 0, h - 1, w - 1, FALSE);
+    }
+
+    if ((p_text_buf != NULL) && (snap->text != NULL)) {
+      p_text_buf->copy_from(*snap->text);
+      val_row = -1;
+    }
+
+    move_cur(snap->cur_y, snap->cur_x);
+  }
 };
 
 WINDOW* Window::get_win_handle() {
   return pimpl->get_win_handle();
 }
 
+bool Window::is_managed() {
+  return pimpl->is_managed();
+}
+
+void Window::get_size(size_spec_t& h, size_spec_t& w) {
+  pimpl->get_size(h, w);
+}
+
+void Window::invalidate_layout() {
+  for (Window* p_win = this; p_win != NULL; p_win = p_win->parent_window) {
+    p_win->pimpl->set_layout_dirty(true);
+  }
+  screen->request_layout();
+}
+
+bool Window::layout(int h, int w, int y, int x, bool force) {
+  bool changed = pimpl->set_geometry(h, w, y, x, force);
+  if (!changed && !pimpl->needs_layout()) {
+    return false;
+  }
+  pimpl->set_layout_dirty(false);
+
+  int area_h, area_w, area_y, area_x;
+  pimpl->get_content_area(area_h, area_w, area_y, area_x);
+
+  layout_dir_t dir = pimpl->get_layout();
+
+  std::vector<Window*> managed;
+  std::vector<size_spec_t> specs;
+  for (auto child : children) {
+    if (child->is_managed()) {
+      size_spec_t h_spec, w_spec;
+      child->get_size(h_spec, w_spec);
+      managed.push_back(child);
+      specs.push_back((dir == LAYOUT_ROW) ? w_spec : h_spec);
+    }
+  }
+
+  if (managed.empty()) {
+    return changed;
+  }
+
+  std::vector<int> sizes(managed.size(), 0);
+  if (dir != LAYOUT_NONE) {
+    layout_distribute(&specs[0], managed.size(),
+        (dir == LAYOUT_ROW) ? area_w : area_h, &sizes[0]);
+  }
+
+  std::vector<int> rects(4 * managed.size(), 0);
+  int offset = 0;
+  for (std::size_t i = 0; i < managed.size(); i++) {
+    size_spec_t h_spec, w_spec;
+    managed[i]->get_size(h_spec, w_spec);
+
+    int* rect = &rects[4 * i];
+    rect[0] = h_spec.resolve(area_h);
+    rect[1] = w_spec.resolve(area_w);
+    rect[2] = area_y;
+    rect[3] = area_x;
+
+    if (dir == LAYOUT_ROW) {
+      rect[1] = sizes[i];
+      rect[3] += offset;
+      offset += rect[1];
+    } else if (dir == LAYOUT_COLUMN) {
+      rect[0] = sizes[i];
+      rect[2] += offset;
+      offset += rect[0];
+    }
+
+    /* Children share memory with the parent, blank every old area before any
+     * child draws in its new one */
+    if (!changed &&
+        managed[i]->pimpl->geometry_changed(rect[0], rect[1], rect[2], rect[3])) {
+      managed[i]->pimpl->vacate();
+    }
+  }
+
+  bool child_changed = false;
+  for (std::size_t i = 0; i < managed.size(); i++) {
+    int* rect = &rects[4 * i];
+    /* Parent was repainted, so are the children in its memory */
+    if (managed[i]->layout(rect[0], rect[1], rect[2], rect[3], changed)) {
+      child_changed = true;
+    }
+  }
+
+  /* Children may have blanked the border while moving */
+  if (child_changed) {
+    pimpl->restore_border();
+    pimpl->mark_dirty();
+  }
+
+  return changed;
+}
+
 void Window::add_child(Window* child) {
   children.push_back(child);
 }
@@ -502,64 +2019,133 @@ Window::Window(
     const int h, const int w,
     const int y, const int x,
     bool bordered,
-    bool textfield
+    bool textfield,
+    bool visible
+  ) : Window(&Screen::get_current(), h, w, y, x, bordered, textfield,
+      visible) {
+
+}
+
+Window::Window(
+    Screen* p_scr,
+    const int h, const int w,
+    const int y, const int x,
+    bool bordered,
+    bool textfield,
+    bool visible
   ) : pimpl(
         new WindowImpl(
           this,
+          p_scr,
           NULL,
           h, w,
           y, x,
           bordered,
-          textfield
+          textfield,
+          visible
         )
-      ) {
+      ), parent_window(NULL), screen(p_scr) {
 
-  Screen::get_instance().add_win(this);
+  screen->add_win(this);
 }
 
 Window::Window(
-    Window* parent_window,
+    Window* p_parent_win,
     const int h, const int w,
     const int y, const int x,
     bool bordered,
-    bool textfield
+    bool textfield,
+    bool visible
   ) : pimpl(
     new WindowImpl(
       this,
-      parent_window->get_win_handle(),
+      p_parent_win->screen,
+      p_parent_win,
       h, w,
       y, x,
       bordered,
-      textfield
+      textfield,
+      visible
     )
-  ) {
+  ), parent_window(p_parent_win), screen(p_parent_win->screen) {
 
   parent_window->add_child(this);
-  Screen::get_instance().add_win(this);
+  screen->add_win(this);
 }
 
 Window::~Window() {
+  /* Children are destroyed with their parent, their ncurses windows are
+   * derived from its own */
+  while (!children.empty()) {
+    delete children.back();
+  }
+
+  /* The window is erased from its terminal, uncovering the windows under
+   * it */
+  screen->activate();
+  if (is_visible()) {
+    pimpl->hide(true);
+  }
   if (parent_window != NULL) {
     parent_window->del_child(this);
+    if (is_managed()) {
+      parent_window->invalidate_layout();
+    }
+  } else if (is_managed()) {
+    screen->request_layout();
   }
-  Screen::get_instance().remove_win(this);
+  screen->remove_win(this);
 }
 
 Window* Window::create_window(const int _h, const int _w,
     const int _y, const int _x,
     bool _is_bordered,
-    bool _is_textfield) {
+    bool _is_textfield,
+    bool _is_visible) {
 
   Window* new_win = NULL;
+  /* Other screens may be running on their render threads */
+  Screen::lock();
   try {
     new_win  = new Window(_h, _w,
         _y, _x,
         _is_bordered,
-        _is_textfield);
+        _is_textfield,
+        _is_visible);
   }
   catch(std::exception e) {
+    Screen::unlock();
+    return NULL;
+  }
+  Screen::unlock();
+  return new_win;
+}
+
+Window* Window::create_window(
+    Screen* p_scr,
+    const int h, const int w,
+    const int y, const int x,
+    bool bordered,
+    bool textfield,
+    bool visible
+  ) {
+
+  Window* new_win = NULL;
+  Screen::lock();
+  try {
+    new_win = new Window(
+        p_scr,
+        h, w,
+        y, x,
+        bordered,
+        textfield,
+        visible
+      );
+  } catch(std::exception e) {
+    Screen::unlock();
     return NULL;
   }
+  Screen::unlock();
   return new_win;
 }
 
@@ -568,31 +2154,70 @@ Window* Window::create_window(
     const int h, const int w,
     const int y, const int x,
     bool bordered,
-    bool textfield
+    bool textfield,
+    bool visible
   ) {
 
   Window* new_win = NULL;
+  Screen::lock();
   try {
     new_win = new Window(
         p_parent_win,
         h, w,
         y, x,
         bordered,
-        textfield
+        textfield,
+        visible
       );
   } catch(std::exception e) {
+    Screen::unlock();
     return NULL;
   }
+  Screen::unlock();
   return new_win;
 }
 
 void Window::destroy_win(Window *win) {
   if (win != NULL) {
-    delete win;
+    Screen::lock();
+    /* Windows destroyed by handlers are deleted once the dispatch ends */
+    if (!win->screen->defer_destroy(win)) {
+      delete win;
+    }
+    Screen::unlock();
     win = NULL;
   }
 }
 
+win_snapshot_t* Window::snapshot(bool cells) {
+  screen->activate();
+  return pimpl->snapshot(cells);
+}
+
+win_snapshot_t* Window::snapshot() {
+  return snapshot(true);
+}
+
+void Window::restore(const win_snapshot_t* snap) {
+  if (snap != NULL) {
+    pimpl->restore(snap);
+  }
+}
+
+void Window::destroy_snapshot(win_snapshot_t* snap) {
+  if (snap != NULL) {
+    if (snap->cells != NULL) {
+      delwin(snap->cells);
+    }
+    delete snap->text;
+    delete snap;
+  }
+}
+
+Screen* Window::get_screen() {
+  return screen;
+}
+
 void Window::reg_cb(win_cb_t cb, win_cb_data_t cb_data) {
   pimpl->reg_cb(cb, cb_data);
 }
@@ -614,6 +2239,30 @@ void Window::dereg_cb(win_event_t ev) {
   pimpl->dereg_cb(ev);
 }
 
+int Window::on_key(const key_handler_t& handler, bool capture) {
+  return pimpl->subscribe(WIN_EV_KEY, handler, capture);
+}
+
+int Window::on_term(const key_handler_t& handler, bool capture) {
+  return pimpl->subscribe(WIN_EV_TERM, handler, capture);
+}
+
+int Window::on_mouse(const mouse_handler_t& handler, bool capture) {
+  return pimpl->subscribe(WIN_EV_MOUSE, handler, capture);
+}
+
+int Window::on_resize(const resize_handler_t& handler, bool capture) {
+  return pimpl->subscribe(WIN_EV_RESIZE, handler, capture);
+}
+
+void Window::unsubscribe(int id) {
+  pimpl->unsubscribe(id);
+}
+
+void Window::notify(win_event_t ev, const Event& e, win_ev_cb_data_t cb_data) {
+  pimpl->notify(ev, e, cb_data);
+}
+
 void Window::box() {
   pimpl->box();
 }
@@ -626,6 +2275,122 @@ void Window::print(std::string str) {
   pimpl->print(0, 0, str);
 }
 
+void Window::print(int y, int x, std::string str, style_id_t style) {
+  pimpl->print(y, x, str, style);
+}
+
+void Window::print(int y, int x, const styled_span_t* spans,
+    std::size_t count) {
+  pimpl->print(y, x, spans, count);
+}
+
+void Window::print(int y, int x, const std::vector<styled_span_t>& spans) {
+  pimpl->print(y, x, spans.data(), spans.size());
+}
+
+bool Window::set_constraints(const field_constraints_t& c) {
+  return pimpl->set_constraints(c);
+}
+
+void Window::clear_constraints() {
+  pimpl->clear_constraints();
+}
+
+text_view_t Window::text() {
+  return pimpl->text();
+}
+
+bool Window::set_text(const char* text, std::size_t len) {
+  return pimpl->set_text(text, len);
+}
+
+bool Window::set_text(const std::string& text) {
+  return pimpl->set_text(text.data(), text.size());
+}
+
+keymap_t& Window::get_keymap() {
+  return pimpl->get_keymap();
+}
+
+bool Window::undo() {
+  return pimpl->undo();
+}
+
+bool Window::redo() {
+  return pimpl->redo();
+}
+
+void Window::set_undo_limit(int edits) {
+  pimpl->set_undo_limit(edits);
+}
+
+int Window::find(const std::string& query) {
+  return pimpl->find(query);
+}
+
+bool Window::find_next(bool forward) {
+  int row, col;
+  return pimpl->find_next(forward, row, col);
+}
+
+bool Window::find_next(int& row, int& col, bool forward) {
+  return pimpl->find_next(forward, row, col);
+}
+
+void Window::set_find_styles(style_id_t match, style_id_t current) {
+  pimpl->set_find_styles(match, current);
+}
+
+bool Window::set_scrollable(int rows, int cols) {
+  return pimpl->set_scrollable(rows, cols);
+}
+
+void Window::scroll_to(int row, int col) {
+  pimpl->scroll_to(row, col);
+}
+
+void Window::scroll_by(int rows, int cols) {
+  int row, col;
+  pimpl->get_scroll(row, col);
+  pimpl->scroll_to(row + rows, col + cols);
+}
+
+void Window::get_scroll(int& row, int& col) {
+  pimpl->get_scroll(row, col);
+}
+
+void Window::set_background(style_id_t style) {
+  pimpl->set_background(style);
+}
+
+void Window::set_border_style(style_id_t style) {
+  pimpl->set_border_style(style);
+}
+
+void Window::set_border(border_t kind) {
+  pimpl->set_border(kind);
+}
+
+void Window::set_title(const std::string& title) {
+  pimpl->set_title(title);
+}
+
+void Window::set_layout(layout_dir_t dir) {
+  if (pimpl->get_layout() != dir) {
+    pimpl->set_layout(dir);
+    invalidate_layout();
+  }
+}
+
+void Window::set_size(size_spec_t h, size_spec_t w) {
+  size_spec_t cur_h, cur_w;
+  pimpl->get_size(cur_h, cur_w);
+  if (!is_managed() || (cur_h != h) || (cur_w != w)) {
+    pimpl->set_size(h, w);
+    invalidate_layout();
+  }
+}
+
 void Window::move(int y, int x) {
   pimpl->move(y, x);
 }
@@ -651,8 +2416,20 @@ void Window::draw() {
   pimpl->draw();
 }
 
-void Window::update() {
-  pimpl->update();
+bool Window::update() {
+  return pimpl->update();
+}
+
+bool Window::compose() {
+  return pimpl->update(false);
+}
+
+void Window::raise() {
+  screen->restack(this, true);
+}
+
+void Window::lower() {
+  screen->restack(this, false);
 }
 
 int Window::getchar() {
@@ -682,3 +2459,27 @@ void Window::mark_dirty() {
 bool Window::enclose(int y, int x) {
   return pimpl->enclose(y, x);
 }
+
+void Window::show() {
+  screen->activate();
+  pimpl->show();
+}
+
+void Window::hide(bool release) {
+  screen->activate();
+  pimpl->hide(release);
+
+  /* Input goes to the next textfield shown */
+  Window* focused = screen->focused_win;
+  if ((focused != NULL) && !focused->is_visible()) {
+    screen->set_focus_next(focused);
+  }
+}
+
+bool Window::is_visible() {
+  return pimpl->is_shown();
+}
+
+bool Window::is_realized() {
+  return pimpl->is_realized();
+}
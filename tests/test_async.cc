@@ -0,0 +1,107 @@
+/**
+ * @file test_async.cc
+ * @brief Test a multi-step flow written as coroutines.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+void status(Window* win, std::string msg)
+{
+  msg.resize(48, ' ');
+  win->print(0, 0, msg);
+}
+
+task<int> read_number(Window* field, Window* status_win)
+{
+  int value = 0;
+  int digits = 0;
+
+  for (;;) {
+    int key = co_await next_key(field);
+    if ((key == 10) && (digits > 0)) {
+      co_return value;
+    }
+    if ((key >= '0') && (key <= '9') && (digits < 2)) {
+      value = (value * 10) + (key - '0');
+      ++digits;
+      status(status_win, "Number: " + std::to_string(value));
+    } else {
+      status(status_win, "Up to 2 digits, then Enter");
+    }
+  }
+}
+
+task<> flow(Window* field, Window* status_win)
+{
+  status(status_win, "Type a number of seconds, then Enter");
+  int secs = co_await read_number(field, status_win);
+
+  for (int i = secs; i > 0; i--) {
+    status(status_win, "Fetching in " + std::to_string(i) + " s");
+    co_await sleep_for(1000);
+  }
+
+  FILE* pipe = popen("sleep 1; echo fetched at $(date +%T)", "r");
+  if (pipe == NULL) {
+    status(status_win, "Fetch failed, F4 to exit");
+    co_return;
+  }
+
+  status(status_win, "Waiting for the fetch");
+  char buf[64];
+  std::string result;
+  while (co_await readable(fileno(pipe)) & FD_EV_READ) {
+    ssize_t len = read(fileno(pipe), buf, sizeof(buf));
+    if (len <= 0) {
+      break;
+    }
+    result.append(buf, len);
+  }
+  pclose(pipe);
+
+  if (!result.empty() && (result.back() == '\n')) {
+    result.pop_back();
+  }
+  status(status_win, result + ", F4 to exit");
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  Window* my_win = Window::create_window(14, 60, 1, 1, true, false);
+
+  Window* status_win = Window::create_window(my_win, 3, 50, 1, 5, true, false);
+
+  Window* textfield_win = Window::create_window(my_win, 5, 50, 5, 5, true, true);
+  textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+  scr.set_focus(textfield_win);
+
+  spawn(flow(textfield_win, status_win));
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(textfield_win);
+  Window::destroy_win(status_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
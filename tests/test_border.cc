@@ -0,0 +1,78 @@
+/**
+ * @file test_border.cc
+ * @brief Test kinds of borders and titles. The border of a textfield is not
+ * drawn again when Enter is typed.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define NUM_PANELS 3
+
+Window* panels[NUM_PANELS];
+border_t kinds[NUM_PANELS] = { BORDER_LINE, BORDER_ASCII, BORDER_INVISIBLE };
+const char* kind_names[] = { "line", "ascii", "invisible" };
+
+unsigned long renames = 0;
+
+void key_cb(const KeyEvent& ev)
+{
+  switch (ev.key) {
+    case KEY_F(1):
+      /* Rotate the kinds of borders */
+      for (int i = 0; i < NUM_PANELS; i++) {
+        kinds[i] = (border_t)((kinds[i] + 1) % NUM_PANELS);
+        panels[i]->set_border(kinds[i]);
+        panels[i]->set_title(kind_names[kinds[i]]);
+      }
+      break;
+    case KEY_F(2):
+      panels[0]->set_title("renamed " + std::to_string(++renames) +
+          " times, a title too long to fit");
+      break;
+    case KEY_F(4):
+      Screen::exit_screen();
+      break;
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+  scr.enable_color();
+
+  style_id_t frame_style = scr.add_style(style_t(COLOR_CYAN, -1));
+
+  /* create windows */
+  for (int i = 0; i < NUM_PANELS; i++) {
+    panels[i] = Window::create_window(8, 26, 0, i * 26, true, false);
+    panels[i]->set_border(kinds[i]);
+    panels[i]->set_title(kind_names[kinds[i]]);
+    panels[i]->print(1, 1, "F1 rotate borders");
+    panels[i]->print(2, 1, "F2 rename, F4 exit");
+  }
+  panels[1]->set_border_style(frame_style);
+
+  Window* notes_win = Window::create_window(10, 78, 9, 0, true, true);
+  notes_win->set_title("Notes, Enter keeps the border");
+  notes_win->on_key(key_handler_t::bind<&key_cb>());
+
+  scr.set_focus(notes_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(notes_win);
+  for (int i = NUM_PANELS - 1; i >= 0; i--) {
+    Window::destroy_win(panels[i]);
+  }
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
@@ -61,6 +61,7 @@ int main()
 
   /* create windows */
   Window* my_win = Window::create_window(20, 60, 1, 1, true, false);
+  my_win->reg_event_handler(WIN_EV_MOUSE, &mouse_cb, NULL);
 
   Window* banner_win = Window::create_window(my_win, 3, 50, 2, 5, true, false);
   banner_win->print(0, 0, "Banner");
@@ -73,7 +74,6 @@ int main()
 
   Window* textfield_win = Window::create_window(my_win, 5, 50, 10, 5, true, true);
   textfield_win->reg_event_handler(WIN_EV_KEY, &key_cb, textfield_win);
-  textfield_win->reg_event_handler(WIN_EV_MOUSE, &mouse_cb, NULL);
 
   scr.set_focus(textfield_win);
 
@@ -0,0 +1,143 @@
+/**
+ * @file test_drag.cc
+ * @brief Test selecting cells of a table by dragging the mouse. Motion read
+ * in one go is coalesced to its latest position, presses and releases are
+ * all dispatched.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define TABLE_ROWS 16
+#define TABLE_COLS 6
+#define CELL_WIDTH 12
+
+Window* table_win;
+Window* status_win;
+Window* filter_win;
+
+style_id_t cell_style;
+style_id_t selected_style;
+
+bool dragging = false;
+int anchor_row, anchor_col;
+int sel_top = -1, sel_left = -1, sel_bottom = -1, sel_right = -1;
+
+unsigned long motions = 0;
+unsigned long presses = 0;
+unsigned long releases = 0;
+
+void print_table()
+{
+  for (int row = 0; row < TABLE_ROWS; row++) {
+    for (int col = 0; col < TABLE_COLS; col++) {
+      char cell[CELL_WIDTH + 1];
+      snprintf(cell, sizeof(cell), " r%02d c%d %3d ", row, col,
+          (row * 37 + col * 11) % 1000);
+      bool selected = (row >= sel_top) && (row <= sel_bottom) &&
+        (col >= sel_left) && (col <= sel_right);
+      table_win->print(row, col * CELL_WIDTH, cell,
+          (selected) ? selected_style : cell_style);
+    }
+  }
+}
+
+void print_status()
+{
+  char line[81];
+  snprintf(line, sizeof(line),
+      "motion %lu, press %lu, release %lu | rows %d-%d cols %d-%d | F4 exit",
+      motions, presses, releases, sel_top, sel_bottom, sel_left, sel_right);
+  std::string text = line;
+  text.resize(80, ' ');
+  status_win->print(0, 0, text);
+}
+
+/* The cell under the mouse, clamped to the table */
+void cell_at(const MouseEvent& ev, int& row, int& col)
+{
+  row = std::min(std::max(ev.y - 1, 0), TABLE_ROWS - 1);
+  col = std::min(std::max((ev.x - 1) / CELL_WIDTH, 0), TABLE_COLS - 1);
+}
+
+void mouse_cb(const MouseEvent& ev)
+{
+  int row, col;
+  cell_at(ev, row, col);
+
+  if (ev.bstate & BUTTON1_PRESSED) {
+    ++presses;
+    dragging = true;
+    anchor_row = row;
+    anchor_col = col;
+  }
+  else if (ev.bstate & (BUTTON1_RELEASED | BUTTON1_CLICKED)) {
+    ++releases;
+    dragging = false;
+  }
+  else if (ev.bstate & REPORT_MOUSE_POSITION) {
+    ++motions;
+    if (!dragging) {
+      print_status();
+      return;
+    }
+  }
+  else {
+    return;
+  }
+
+  sel_top = std::min(anchor_row, row);
+  sel_bottom = std::max(anchor_row, row);
+  sel_left = std::min(anchor_col, col);
+  sel_right = std::max(anchor_col, col);
+  print_table();
+  print_status();
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+  scr.enable_color();
+  scr.enable_mouse_events(MOUSE_MOTION_DRAG);
+
+  cell_style = scr.add_style(style_t(-1, -1));
+  selected_style = scr.add_style(style_t(COLOR_BLACK, COLOR_CYAN));
+
+  /* create windows */
+  table_win = Window::create_window(TABLE_ROWS + 2,
+      TABLE_COLS * CELL_WIDTH + 2, 0, 0, true, false);
+  table_win->set_title("Drag to select cells");
+  table_win->on_mouse(mouse_handler_t::bind<&mouse_cb>());
+  print_table();
+
+  filter_win = Window::create_window(3, 74, TABLE_ROWS + 2, 0, true, true);
+  filter_win->on_key(key_handler_t::bind<&key_cb>());
+
+  status_win = Window::create_window(1, 80, TABLE_ROWS + 5, 0, false, false);
+  print_status();
+
+  scr.set_focus(filter_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(status_win);
+  Window::destroy_win(filter_win);
+  Window::destroy_win(table_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file test_find.cc
+ * @brief Test incremental find in a log pane of 30000 rows, searched as the
+ * query is typed.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define LOG_ROWS 30000
+#define LOG_COLS 100
+
+Window* log_win;
+Window* query_win;
+Window* status_win;
+
+int appended = 0;
+int matches = 0;
+long last_us = 0;
+
+const char* levels[] = { "INFO", "WARN", "DEBUG", "ERROR" };
+const char* words[] = {
+  "order accepted", "order rejected", "fill received", "quote updated",
+  "session opened", "session closed", "heartbeat", "risk check passed"
+};
+
+long elapsed_us(const struct timespec& start)
+{
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start.tv_sec) * 1000000L +
+    (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
+void print_log_row(int row, unsigned long seed)
+{
+  char line[LOG_COLS + 1];
+  snprintf(line, sizeof(line),
+      "%06d 12:%02lu:%02lu.%03lu %-5s %-17s id=%08lx venue=%c%c",
+      row, (seed / 60) % 60, seed % 60, seed % 1000, levels[seed % 4],
+      words[(seed >> 3) % 8], seed * 2654435761u & 0xffffffff,
+      'A' + (int)(seed % 26), 'A' + (int)((seed >> 5) % 26));
+  log_win->print(row, 0, line);
+}
+
+void print_status()
+{
+  int row, col;
+  log_win->get_scroll(row, col);
+  status_win->print(0, 0, std::to_string(matches) + " matches in " +
+      std::to_string(last_us) + " us, top " + std::to_string(row) +
+      " | F3 next, F5 prev, F6 change rows, F4 exit          ");
+}
+
+void search()
+{
+  text_view_t text = query_win->text();
+  std::string query = (text.size() > 0) ? text[0].to_string() : "";
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  matches = log_win->find(query);
+  last_us = elapsed_us(start);
+  print_status();
+}
+
+void term_cb(const KeyEvent& ev)
+{
+  search();
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  switch (ev.key) {
+    case KEY_F(3):
+    case KEY_F(5):
+      log_win->find_next(ev.key == KEY_F(3));
+      print_status();
+      break;
+    case KEY_F(6):
+      /* Rewrite 100 rows in the viewport, only those are searched again */
+      {
+        int row, col;
+        log_win->get_scroll(row, col);
+        for (int i = 0; i < 100; i++) {
+          print_log_row(row + i, ++appended * 7919UL);
+        }
+        search();
+      }
+      break;
+    case KEY_F(4):
+      Screen::exit_screen();
+      break;
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  log_win = Window::create_window(19, 80, 0, 0, true, false);
+  log_win->set_scrollable(LOG_ROWS, LOG_COLS);
+  for (int row = 0; row < LOG_ROWS; row++) {
+    print_log_row(row, row * 40503UL);
+  }
+
+  query_win = Window::create_window(3, 80, 19, 0, true, true);
+  query_win->on_term(key_handler_t::bind<&term_cb>());
+  query_win->on_key(key_handler_t::bind<&key_cb>());
+
+  status_win = Window::create_window(1, 80, 22, 0, false, false);
+  print_status();
+
+  scr.set_focus(query_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(status_win);
+  Window::destroy_win(query_win);
+  Window::destroy_win(log_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
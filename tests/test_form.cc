@@ -0,0 +1,108 @@
+/**
+ * @file test_form.cc
+ * @brief Test a form of 100 textfields loaded with set_text and submitted by
+ * reading their text through views, without copying it.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define FORM_ROWS 20
+#define FORM_COLS 5
+#define NUM_FIELDS (FORM_ROWS * FORM_COLS)
+#define FIELD_WIDTH 15
+
+Window* fields[NUM_FIELDS];
+Window* status_win;
+
+unsigned long loads = 0;
+
+void load()
+{
+  ++loads;
+  for (int i = 0; i < NUM_FIELDS; i++) {
+    char value[FIELD_WIDTH + 1];
+    int len = snprintf(value, sizeof(value), "f%02d=%lu", i, loads * (i + 1));
+    fields[i]->set_text(value, len);
+  }
+  status_win->print(0, 0, "Loaded " + std::to_string(NUM_FIELDS) +
+      " fields                                              ");
+}
+
+void submit()
+{
+  std::size_t chars = 0;
+  unsigned long sum = 0;
+  int filled = 0;
+
+  for (int i = 0; i < NUM_FIELDS; i++) {
+    text_view_t text = fields[i]->text();
+    for (text_view_t::const_iterator it = text.begin(); it != text.end();
+        ++it) {
+      line_view_t line = *it;
+      chars += line.len;
+      for (int j = 0; j < line.len; j++) {
+        sum = (sum * 31) + (unsigned char)line.str[j];
+      }
+      filled += (line.len > 0);
+    }
+  }
+
+  char status[80];
+  snprintf(status, sizeof(status),
+      "Submitted %d filled, %zu chars, checksum %08lx          ",
+      filled, chars, sum & 0xffffffff);
+  status_win->print(0, 0, status);
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  switch (ev.key) {
+    case KEY_F(1):
+      load();
+      break;
+    case KEY_F(2):
+      submit();
+      break;
+    case KEY_F(4):
+      Screen::exit_screen();
+      break;
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  style_id_t field_style = scr.add_style(style_t(COLOR_WHITE, COLOR_BLUE));
+
+  /* create windows */
+  for (int i = 0; i < NUM_FIELDS; i++) {
+    fields[i] = Window::create_window(1, FIELD_WIDTH, i / FORM_COLS,
+        (i % FORM_COLS) * (FIELD_WIDTH + 1), false, true);
+    fields[i]->set_background(field_style);
+    fields[i]->on_key(key_handler_t::bind<&key_cb>());
+  }
+
+  status_win = Window::create_window(1, 80, FORM_ROWS + 1, 0, false, false);
+  status_win->print(0, 0, "F1 load, F2 submit, Tab next field, F4 exit");
+
+  scr.set_focus(fields[0]);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(status_win);
+  for (int i = NUM_FIELDS - 1; i >= 0; i--) {
+    Window::destroy_win(fields[i]);
+  }
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
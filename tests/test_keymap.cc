@@ -0,0 +1,97 @@
+/**
+ * @file test_keymap.cc
+ * @brief Test bindings of keys: function keys bound to handlers on the
+ * screen, arrows moving the cursor in the text, and a chord bound in one
+ * window only.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+Window* notes_win;
+Window* title_win;
+Window* status_win;
+
+unsigned long saves = 0;
+
+void print_status(const std::string& msg)
+{
+  std::string line = msg +
+    " | Ctrl-X Ctrl-W save, F2 submit, Shift-Tab back, F4 exit";
+  line.resize(80, ' ');
+  status_win->print(0, 0, line);
+}
+
+void save_cb(const KeyEvent& ev)
+{
+  text_view_t text = notes_win->text();
+  std::size_t chars = 0;
+  for (int row = 0; row < text.size(); row++) {
+    chars += text[row].len;
+  }
+  print_status("Saved " + std::to_string(chars) + " chars, " +
+      std::to_string(++saves) + " times");
+}
+
+void term_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(2)) {
+    text_view_t text = title_win->text();
+    print_status("Title \"" + text[0].to_string() + "\"");
+  }
+}
+
+void exit_cb(const KeyEvent& ev)
+{
+  Screen::exit_screen();
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  keymap_t& keys = scr.get_keymap();
+  keys.bind(KEY_F(4), key_handler_t::bind<&exit_cb>());
+  keys.bind(KEY_F(2), ACTION_SUBMIT);
+  keys.bind(KEY_LEFT, ACTION_CURSOR_LEFT);
+  keys.bind(KEY_RIGHT, ACTION_CURSOR_RIGHT);
+  keys.bind(KEY_UP, ACTION_CURSOR_UP);
+  keys.bind(KEY_DOWN, ACTION_CURSOR_DOWN);
+  keys.bind(KEY_HOME, ACTION_CURSOR_HOME);
+  keys.bind(KEY_END, ACTION_CURSOR_END);
+
+  /* create windows */
+  title_win = Window::create_window(3, 80, 0, 0, true, true);
+  title_win->set_title("Title");
+  title_win->on_term(key_handler_t::bind<&term_cb>());
+
+  notes_win = Window::create_window(8, 80, 3, 0, true, true);
+  notes_win->set_title("Notes");
+
+  /* Ctrl-X Ctrl-W saves the notes, Ctrl-X alone waits for the next key */
+  std::vector<int> save_chord;
+  save_chord.push_back(24);
+  save_chord.push_back(23);
+  notes_win->get_keymap().bind(save_chord, key_handler_t::bind<&save_cb>());
+
+  status_win = Window::create_window(1, 80, 12, 0, false, false);
+  print_status("Type");
+
+  scr.set_focus(title_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(status_win);
+  Window::destroy_win(notes_win);
+  Window::destroy_win(title_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
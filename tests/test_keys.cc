@@ -0,0 +1,112 @@
+/**
+ * @file test_keys.cc
+ * @brief Test decoding of keys: Escape without delay, Alt and other
+ * modifiers, and SGR mouse reports on terminals wider than 223 columns.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define LOG_ROWS 16
+
+Window* input_win;
+Window* log_win;
+Window* status_win;
+
+int logged = 0;
+
+std::string describe(int key)
+{
+  std::string name;
+  if (key_mods(key) & MOD_CTRL) {
+    name += "Ctrl-";
+  }
+  if (key_mods(key) & MOD_ALT) {
+    name += "Alt-";
+  }
+  if (key_mods(key) & MOD_SHIFT) {
+    name += "Shift-";
+  }
+  const char* base = keyname(key_code(key));
+  name += (key_code(key) == 27) ? "Escape" : (base != NULL) ? base : "?";
+  return name;
+}
+
+void log_line(const std::string& line)
+{
+  std::string text = std::to_string(++logged) + " " + line;
+  text.resize(80, ' ');
+  log_win->print(logged % LOG_ROWS, 0, text);
+}
+
+void print_status()
+{
+  std::string line = "Escape delay " +
+    std::to_string(Screen::get_instance().get_escape_delay()) +
+    " ms | F1 25 ms, F2 1000 ms, F4 exit";
+  line.resize(80, ' ');
+  status_win->print(0, 0, line);
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  switch (ev.key) {
+    case KEY_F(1):
+      Screen::get_instance().set_escape_delay(25);
+      print_status();
+      break;
+    case KEY_F(2):
+      Screen::get_instance().set_escape_delay(1000);
+      print_status();
+      break;
+    case KEY_F(4):
+      Screen::exit_screen();
+      break;
+    default:
+      log_line("key " + describe(ev.key));
+  }
+}
+
+void mouse_cb(const MouseEvent& ev)
+{
+  char line[80];
+  snprintf(line, sizeof(line), "mouse row %d col %d state %08lx",
+      ev.y, ev.x, (unsigned long)ev.bstate);
+  log_line(line);
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+  scr.enable_mouse_events();
+
+  /* create windows */
+  input_win = Window::create_window(3, 80, 0, 0, true, true);
+  input_win->set_title("Type keys with modifiers, click anywhere");
+  input_win->on_key(key_handler_t::bind<&key_cb>());
+  input_win->on_mouse(mouse_handler_t::bind<&mouse_cb>());
+
+  log_win = Window::create_window(LOG_ROWS, 80, 3, 0, false, false);
+  log_win->on_mouse(mouse_handler_t::bind<&mouse_cb>());
+
+  status_win = Window::create_window(1, 80, 19, 0, false, false);
+  print_status();
+
+  scr.set_focus(input_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(status_win);
+  Window::destroy_win(log_win);
+  Window::destroy_win(input_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file test_layout.cc
+ * @brief Test layout of windows with size constraints.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+void key_cb(const KeyEvent& ev)
+{
+  switch(ev.key) {
+    case KEY_UP:
+    {
+      ev.window->move_cur_rel(-1, 0);
+      break;
+    }
+    case KEY_DOWN:
+    {
+      ev.window->move_cur_rel(1, 0);
+      break;
+    }
+    case KEY_LEFT:
+    {
+      ev.window->move_cur_rel(0, -1);
+      break;
+    }
+    case KEY_RIGHT:
+    {
+      ev.window->move_cur_rel(0, 1);
+      break;
+    }
+    case KEY_F(4):
+    {
+      Screen::exit_screen();
+    }
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  scr.set_cursor(1);
+  scr.set_layout(LAYOUT_COLUMN);
+
+  /* create windows, the layout computes their geometry */
+  Window* banner_win = Window::create_window(3, 3, 0, 0, true, false);
+  banner_win->on_resize(resize_handler_t::bind(
+        [](const ResizeEvent& ev) {
+          ev.window->print(0, 0, "Resize the terminal, F4 to exit");
+        }
+      ));
+  banner_win->set_size(size_fixed(3), size_flex());
+
+  Window* body_win = Window::create_window(3, 3, 0, 0, true, false);
+  body_win->set_size(size_flex(), size_flex());
+  body_win->set_layout(LAYOUT_ROW);
+
+  Window* side_win = Window::create_window(body_win, 1, 1, 0, 0, true, false);
+  side_win->set_size(size_flex(), size_percent(30, 20, 40));
+
+  Window* form_win = Window::create_window(body_win, 1, 1, 0, 0, false, false);
+  form_win->set_size(size_flex(), size_flex());
+  form_win->set_layout(LAYOUT_COLUMN);
+
+  Window* textfield_win_1 = Window::create_window(form_win, 1, 1, 0, 0, true, true);
+  textfield_win_1->on_key(key_handler_t::bind<&key_cb>());
+  textfield_win_1->set_size(size_flex(1, 3), size_flex());
+
+  Window* textfield_win_2 = Window::create_window(form_win, 1, 1, 0, 0, true, true);
+  textfield_win_2->on_key(key_handler_t::bind<&key_cb>());
+  textfield_win_2->set_size(size_flex(2, 3), size_flex());
+
+  scr.set_focus(textfield_win_1);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(textfield_win_2);
+  Window::destroy_win(textfield_win_1);
+  Window::destroy_win(form_win);
+  Window::destroy_win(side_win);
+  Window::destroy_win(body_win);
+  Window::destroy_win(banner_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
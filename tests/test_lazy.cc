@@ -0,0 +1,136 @@
+/**
+ * @file test_lazy.cc
+ * @brief Test windows realized when first shown, with tabs of 100 widgets
+ * each, only the first of them shown at startup.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define NUM_TABS 3
+#define WIDGET_ROWS 10
+#define WIDGET_COLS 10
+#define NUM_WIDGETS (WIDGET_ROWS * WIDGET_COLS)
+
+Window* banner_win;
+Window* tabs[NUM_TABS];
+Window* widgets[NUM_TABS][NUM_WIDGETS];
+Window* fields[NUM_TABS];
+
+int cur_tab = 0;
+bool release = false;
+
+int count_realized()
+{
+  int count = 0;
+  for (int tab = 0; tab < NUM_TABS; tab++) {
+    count += tabs[tab]->is_realized() + fields[tab]->is_realized();
+    for (int i = 0; i < NUM_WIDGETS; i++) {
+      count += widgets[tab][i]->is_realized();
+    }
+  }
+  return count;
+}
+
+void print_banner()
+{
+  banner_win->print(0, 0, "Tab " + std::to_string(cur_tab + 1) +
+      ", realized " + std::to_string(count_realized()) + "/" +
+      std::to_string(NUM_TABS * (NUM_WIDGETS + 2)) +
+      ((release) ? ", release" : ", keep   ") +
+      "  F1-F3 tab, F5 release, F4 exit");
+}
+
+void print_label(Window* w)
+{
+  for (int tab = 0; tab < NUM_TABS; tab++) {
+    Window** found = std::find(widgets[tab], widgets[tab] + NUM_WIDGETS, w);
+    if (found != widgets[tab] + NUM_WIDGETS) {
+      char label[8];
+      snprintf(label, sizeof(label), "%c%02d", 'a' + tab,
+          (int)(found - widgets[tab]));
+      w->print(0, 0, label);
+    }
+  }
+}
+
+void label_cb(const ResizeEvent& ev)
+{
+  print_label(ev.window);
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  Screen& scr = Screen::get_instance();
+
+  if ((ev.key >= KEY_F(1)) && (ev.key < KEY_F(1 + NUM_TABS))) {
+    int tab = ev.key - KEY_F(1);
+    if (tab != cur_tab) {
+      tabs[cur_tab]->hide(release);
+      tabs[tab]->show();
+      cur_tab = tab;
+      scr.set_focus(fields[tab]);
+    }
+    print_banner();
+  } else if (ev.key == KEY_F(5)) {
+    release = !release;
+    print_banner();
+  } else if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  Window* my_win = Window::create_window(20, 76, 0, 0, true, false);
+
+  banner_win = Window::create_window(my_win, 3, 72, 1, 2, true, false);
+
+  for (int tab = 0; tab < NUM_TABS; tab++) {
+    tabs[tab] = Window::create_window(my_win, 15, 72, 4, 2, false, false,
+        tab == 0);
+
+    /* Labels are printed when the widgets are realized, those of the first
+     * tab already are */
+    for (int i = 0; i < NUM_WIDGETS; i++) {
+      Window* w = Window::create_window(tabs[tab], 1, 7,
+          i / WIDGET_COLS, 1 + 7 * (i % WIDGET_COLS), false, false);
+      w->on_resize(resize_handler_t::bind<&label_cb>());
+      widgets[tab][i] = w;
+      if (w->is_realized()) {
+        print_label(w);
+      }
+    }
+
+    fields[tab] = Window::create_window(tabs[tab], 3, 70, 11, 1, true, true);
+    fields[tab]->on_key(key_handler_t::bind<&key_cb>());
+  }
+
+  scr.set_focus(fields[0]);
+  print_banner();
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  for (int tab = NUM_TABS - 1; tab >= 0; tab--) {
+    Window::destroy_win(fields[tab]);
+    for (int i = NUM_WIDGETS - 1; i >= 0; i--) {
+      Window::destroy_win(widgets[tab][i]);
+    }
+    Window::destroy_win(tabs[tab]);
+  }
+  Window::destroy_win(banner_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
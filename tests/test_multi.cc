@@ -0,0 +1,76 @@
+/**
+ * @file test_multi.cc
+ * @brief Test screens on several terminals driven by one event loop.
+ * Run with the device of each terminal, e.g. test_multi /dev/pts/1 /dev/pts/2
+ * while the shells of those terminals are kept from reading input, e.g. with
+ * sleep.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+struct term {
+  FILE* fp;
+  Screen* scr;
+  Window* my_win;
+  Window* banner_win;
+  Window* textfield_win;
+};
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    /* Only the terminal where F4 was pressed exits */
+    Screen::exit_screen();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s TTY...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<struct term> terms;
+
+  /* initialize a screen on each terminal */
+  for (int i = 1; i < argc; i++) {
+    struct term t;
+    t.fp = fopen(argv[i], "r+");
+    if (t.fp == NULL) {
+      continue;
+    }
+    t.scr = Screen::create_screen(NULL, t.fp, t.fp);
+    if (t.scr == NULL) {
+      fclose(t.fp);
+      continue;
+    }
+    t.scr->set_cursor(1);
+
+    t.my_win = Window::create_window(t.scr, 14, 60, 1, 1, true, false);
+
+    t.banner_win = Window::create_window(t.my_win, 3, 50, 1, 5, true, false);
+    t.banner_win->print(0, 0, std::string("Terminal ") + argv[i] +
+        ", F4 to exit");
+
+    t.textfield_win = Window::create_window(t.my_win, 5, 50, 5, 5, true, true);
+    t.textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+    t.scr->set_focus(t.textfield_win);
+
+    terms.push_back(t);
+  }
+
+  /* main loop */
+  Screen::mainloop_all();
+
+  /* deinitialize */
+  for (auto& t : terms) {
+    Screen::destroy_screen(t.scr);
+    fclose(t.fp);
+  }
+
+  return 0;
+}
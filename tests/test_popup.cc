@@ -0,0 +1,123 @@
+/**
+ * @file test_popup.cc
+ * @brief Test a modal confirm popup over a table of 10000 rows. Dismissing
+ * the popup copies back the cells under it.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define TABLE_ROWS 10000
+#define TABLE_COLS 76
+
+Window* table_win;
+Window* status_win;
+Window* popup_win;
+
+bool ticking = false;
+unsigned long ticks = 0;
+
+void* tick_cb(timer_cb_data_t cb_data)
+{
+  if (ticking) {
+    ++ticks;
+    int row, col;
+    table_win->get_scroll(row, col);
+    table_win->print(row + 8, 0, "tick " + std::to_string(ticks) +
+        " changed under the popup      ");
+  }
+  return 0;
+}
+
+void popup_cb(const ResizeEvent& ev)
+{
+  ev.window->print(0, 0, "Delete the selected row? y/n");
+}
+
+void answer_cb(const KeyEvent& ev)
+{
+  Screen& scr = Screen::get_instance();
+
+  if ((ev.key == 'y') || (ev.key == 'n')) {
+    scr.pop_popup();
+    status_win->print(0, 0, std::string("Answered ") + (char)ev.key +
+        ", F1 confirm, F2 tick, arrows scroll, F4 exit");
+  }
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  Screen& scr = Screen::get_instance();
+
+  switch (ev.key) {
+    case KEY_UP:
+      table_win->scroll_by(-1, 0);
+      break;
+    case KEY_DOWN:
+      table_win->scroll_by(1, 0);
+      break;
+    case KEY_NPAGE:
+      table_win->scroll_by(18, 0);
+      break;
+    case KEY_F(1):
+      scr.push_popup(popup_win);
+      break;
+    case KEY_F(2):
+      ticking = !ticking;
+      break;
+    case KEY_F(4):
+      Screen::exit_screen();
+      break;
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  table_win = Window::create_window(20, 80, 0, 0, true, false);
+  table_win->set_scrollable(TABLE_ROWS, TABLE_COLS);
+  for (int i = 0; i < TABLE_ROWS; i++) {
+    char line[TABLE_COLS + 1];
+    snprintf(line, sizeof(line), "%6d  order %08x  qty %4d  price %9.2f  %s",
+        i + 1, i * 2654435761u, (i * 37) % 1000, (i % 977) * 1.25,
+        (i % 3) ? "open" : "filled");
+    table_win->print(i, 0, line);
+  }
+
+  Window* cmd_win = Window::create_window(3, 80, 20, 0, true, true);
+  cmd_win->on_key(key_handler_t::bind<&key_cb>());
+
+  status_win = Window::create_window(1, 80, 23, 0, false, false);
+  status_win->print(0, 0, "F1 confirm, F2 tick, arrows scroll, F4 exit");
+
+  /* the popup is created hidden and realized when first pushed */
+  popup_win = Window::create_window(7, 40, 6, 20, true, false, false);
+  popup_win->on_resize(resize_handler_t::bind<&popup_cb>());
+
+  Window* answer_win = Window::create_window(popup_win, 3, 36, 3, 2, true,
+      true);
+  answer_win->on_term(key_handler_t::bind<&answer_cb>());
+
+  scr.set_focus(cmd_win);
+  scr.add_timer(200, &tick_cb, NULL, true);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(answer_win);
+  Window::destroy_win(popup_win);
+  Window::destroy_win(status_win);
+  Window::destroy_win(cmd_win);
+  Window::destroy_win(table_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
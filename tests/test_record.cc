@@ -0,0 +1,80 @@
+/**
+ * @file test_record.cc
+ * @brief Test recording the frames of a session, replay the recording with
+ * tools/ncui_replay.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+struct pane {
+  Window* win;
+  int ticks;
+};
+
+struct pane panes[3];
+
+void* tick_cb(timer_cb_data_t cb_data)
+{
+  struct pane* p = (struct pane*)cb_data;
+  p->win->print(0, 0, "ticks: " + std::to_string(++p->ticks));
+  return 0;
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  const char* path = (argc > 1) ? argv[1] : "session.rec";
+  FILE* rec_fp = fopen(path, "wb");
+  if (rec_fp == NULL) {
+    perror(path);
+    return EXIT_FAILURE;
+  }
+
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+  scr.start_recording(rec_fp);
+
+  /* create windows */
+  Window* my_win = Window::create_window(20, 60, 1, 1, true, false);
+
+  Window* banner_win = Window::create_window(my_win, 3, 50, 1, 5, true, false);
+  banner_win->print(0, 0, "Recording to " + std::string(path) +
+      ", F4 to exit");
+
+  for (int i = 0; i < 3; i++) {
+    panes[i].win = Window::create_window(my_win, 3, 50, 4 + 3 * i, 5, true, false);
+    panes[i].ticks = 0;
+    scr.add_timer(100 * (i + 1), &tick_cb, &panes[i], true);
+  }
+
+  Window* textfield_win = Window::create_window(my_win, 5, 50, 13, 5, true, true);
+  textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+  scr.set_focus(textfield_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(textfield_win);
+  for (int i = 2; i >= 0; i--) {
+    Window::destroy_win(panes[i].win);
+  }
+  Window::destroy_win(banner_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+  fclose(rec_fp);
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file test_replay.cc
+ * @brief Load test a form of 50 textfields with recorded or generated input.
+ *
+ * test_replay record FILE        record keys typed into the form
+ * test_replay gen FILE [COUNT]   generate COUNT keys, 10000 by default
+ * test_replay play FILE [fast]   replay keys at their pace or as fast as
+ *                                possible, then report the rate and the
+ *                                allocations
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define FIELD_ROWS 10
+#define FIELD_COLS 5
+#define NUM_FIELDS (FIELD_ROWS * FIELD_COLS)
+
+static unsigned long allocations = 0;
+
+void* operator new(std::size_t size)
+{
+  ++allocations;
+  void* p = malloc(size);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+input_replayer_t* replayer = NULL;
+
+void* done_cb(timer_cb_data_t cb_data)
+{
+  if (replayer->is_done()) {
+    Screen::exit_screen();
+  }
+  return 0;
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int generate(FILE* fp, unsigned long count)
+{
+  input_recorder_t rec(fp);
+  input_event_t ev;
+  memset(&ev, 0, sizeof(ev));
+
+  /* Type a few letters into each field, erase some and move on */
+  for (unsigned long i = 0; i < count; i++) {
+    int step = i % 13;
+    if (step < 8) {
+      ev.key = 'a' + (i % 26);
+    } else if (step < 12) {
+      ev.key = KEY_BACKSPACE;
+    } else {
+      ev.key = 9;
+    }
+    ev.time += 30;
+    rec.record(ev);
+  }
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s record|gen|play FILE [COUNT|fast]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::string mode = argv[1];
+  bool recording = (mode == "record");
+  FILE* fp = fopen(argv[2], (recording || (mode == "gen")) ? "wb" : "rb");
+  if (fp == NULL) {
+    perror(argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  if (mode == "gen") {
+    int ret = generate(fp, (argc > 3) ? strtoul(argv[3], NULL, 10) : 10000);
+    fclose(fp);
+    return ret;
+  }
+
+  input_replayer_t player(fp, !((argc > 3) && (std::string(argv[3]) == "fast")));
+  if (!recording) {
+    if (!player.is_valid()) {
+      fprintf(stderr, "%s is not an input recording\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+    replayer = &player;
+  }
+
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  Window* my_win = Window::create_window(3 * FIELD_ROWS + 5, 14 * FIELD_COLS + 4,
+      0, 0, true, false);
+
+  Window* banner_win = Window::create_window(my_win, 3, 14 * FIELD_COLS, 1, 2,
+      true, false);
+  banner_win->print(0, 0, (recording) ? "Recording, Tab to move, F4 to exit" :
+      "Replaying, F4 to exit");
+
+  Window* fields[NUM_FIELDS];
+  for (int i = 0; i < NUM_FIELDS; i++) {
+    fields[i] = Window::create_window(my_win, 3, 14,
+        4 + 3 * (i / FIELD_COLS), 2 + 14 * (i % FIELD_COLS), true, true);
+    fields[i]->on_key(key_handler_t::bind<&key_cb>());
+  }
+
+  scr.set_focus(fields[0]);
+
+  if (recording) {
+    scr.start_recording_input(fp);
+  } else {
+    scr.set_input_source(&player);
+    scr.add_timer(10, &done_cb, NULL, true);
+  }
+
+  /* main loop */
+  uint64_t start = monotonic_ms();
+  unsigned long start_allocs = allocations;
+
+  scr.mainloop();
+
+  uint64_t elapsed = monotonic_ms() - start;
+  unsigned long allocs = allocations - start_allocs;
+
+  /* deinitialize */
+  for (int i = NUM_FIELDS - 1; i >= 0; i--) {
+    Window::destroy_win(fields[i]);
+  }
+  Window::destroy_win(banner_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+  fclose(fp);
+
+  if (!recording) {
+    unsigned long count = player.get_count();
+    printf("events:      %lu in %.3f s, %.0f/s, one frame each\n",
+        count, elapsed / 1000.0,
+        (elapsed > 0) ? count * 1000.0 / elapsed : 0.0);
+    printf("allocations: %lu, %.2f per event\n", allocs,
+        (count > 0) ? (double)allocs / count : 0.0);
+  }
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
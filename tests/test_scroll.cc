@@ -0,0 +1,104 @@
+/**
+ * @file test_scroll.cc
+ * @brief Test scrolling a report of 5000 lines in a window backed by a pad.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define REPORT_LINES 5000
+#define REPORT_COLS 120
+
+Window* banner_win;
+Window* report_win;
+
+void show_position()
+{
+  int row, col;
+  report_win->get_scroll(row, col);
+  banner_win->print(0, 0, "Line " + std::to_string(row + 1) + ", column " +
+      std::to_string(col + 1) + "        ");
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  switch (ev.key) {
+    case KEY_UP:
+      report_win->scroll_by(-1, 0);
+      break;
+    case KEY_DOWN:
+      report_win->scroll_by(1, 0);
+      break;
+    case KEY_LEFT:
+      report_win->scroll_by(0, -4);
+      break;
+    case KEY_RIGHT:
+      report_win->scroll_by(0, 4);
+      break;
+    case KEY_PPAGE:
+      report_win->scroll_by(-12, 0);
+      break;
+    case KEY_NPAGE:
+      report_win->scroll_by(12, 0);
+      break;
+    case KEY_HOME:
+      report_win->scroll_to(0, 0);
+      break;
+    case KEY_END:
+      report_win->scroll_to(REPORT_LINES, 0);
+      break;
+    case KEY_F(4):
+      Screen::exit_screen();
+      return;
+  }
+  show_position();
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  Window* my_win = Window::create_window(22, 60, 1, 1, true, false);
+
+  Window* help_win = Window::create_window(my_win, 3, 50, 1, 5, true, false);
+  help_win->print(0, 0, "Arrows, PgUp, PgDn, Home, End, F4 to exit");
+
+  banner_win = Window::create_window(my_win, 1, 50, 4, 6, false, false);
+
+  report_win = Window::create_window(my_win, 14, 50, 5, 5, true, false);
+  report_win->set_scrollable(REPORT_LINES, REPORT_COLS);
+
+  /* the content is printed once */
+  for (int i = 0; i < REPORT_LINES; i++) {
+    std::string line = "line " + std::to_string(i + 1) + ":";
+    while ((int)line.length() < REPORT_COLS) {
+      line += " " + std::to_string((i * 31 + line.length()) % 1000);
+    }
+    report_win->print(i, 0, line);
+  }
+  show_position();
+
+  Window* textfield_win = Window::create_window(my_win, 1, 50, 20, 5, false, true);
+  textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+  scr.set_focus(textfield_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(textfield_win);
+  Window::destroy_win(report_win);
+  Window::destroy_win(banner_win);
+  Window::destroy_win(help_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
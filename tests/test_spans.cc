@@ -0,0 +1,118 @@
+/**
+ * @file test_spans.cc
+ * @brief Test printing lines of styled spans, as a colorized log.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define LOG_ROWS 14
+#define LOG_COLS 56
+
+struct log_line {
+  std::string stamp;
+  int level;
+  std::string msg;
+};
+
+const char* levels[4] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+const char* messages[4] = {
+  "connection accepted from 10.0.0.",
+  "request served in ",
+  "slow response from backend ",
+  "upstream reset by peer "
+};
+
+Window* log_win;
+style_id_t stamp_style;
+style_id_t text_style;
+style_id_t level_styles[4];
+std::vector<log_line> lines;
+std::string padding(LOG_COLS, ' ');
+int seq = 0;
+
+void* tick_cb(timer_cb_data_t cb_data)
+{
+  log_line line;
+  line.stamp = "12:00:" + std::to_string(10 + seq / 10 % 50) + "." +
+    std::to_string(seq % 10) + " ";
+  line.level = (seq * 7) % 11 % 4;
+  line.msg = std::string(" ") + messages[line.level] + std::to_string(seq);
+  ++seq;
+
+  lines.push_back(line);
+  if (lines.size() > LOG_ROWS) {
+    lines.erase(lines.begin());
+  }
+
+  /* The message and the padding share a style and are written as one run */
+  styled_span_t spans[4];
+  for (std::size_t i = 0; i < lines.size(); i++) {
+    spans[0].text = lines[i].stamp.c_str();
+    spans[0].len = lines[i].stamp.size();
+    spans[0].style = stamp_style;
+    spans[1].text = levels[lines[i].level];
+    spans[1].len = -1;
+    spans[1].style = level_styles[lines[i].level];
+    spans[2].text = lines[i].msg.c_str();
+    spans[2].len = lines[i].msg.size();
+    spans[2].style = text_style;
+    spans[3].text = padding.c_str();
+    spans[3].len = padding.size();
+    spans[3].style = text_style;
+    log_win->print(i, 0, spans, 4);
+  }
+  return 0;
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+  scr.enable_color();
+
+  stamp_style = scr.add_style(style_t(-1, -1, A_DIM));
+  text_style = scr.add_style(style_t());
+  level_styles[0] = scr.add_style(style_t(COLOR_BLUE, -1));
+  level_styles[1] = scr.add_style(style_t(COLOR_GREEN, -1));
+  level_styles[2] = scr.add_style(style_t(COLOR_YELLOW, -1, A_BOLD));
+  level_styles[3] = scr.add_style(style_t(COLOR_WHITE, COLOR_RED, A_BOLD));
+
+  /* create windows */
+  Window* my_win = Window::create_window(22, 62, 1, 1, true, false);
+
+  Window* banner_win = Window::create_window(my_win, 3, 58, 1, 2, true, false);
+  banner_win->print(0, 0, "Log lines every 200 ms, F4 to exit");
+
+  log_win = Window::create_window(my_win, LOG_ROWS + 2, 58, 4, 2, true, false);
+
+  Window* textfield_win = Window::create_window(my_win, 1, 58, 20, 2, false, true);
+  textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+  scr.add_timer(200, &tick_cb, NULL, true);
+
+  scr.set_focus(textfield_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(textfield_win);
+  Window::destroy_win(log_win);
+  Window::destroy_win(banner_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
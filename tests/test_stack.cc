@@ -0,0 +1,97 @@
+/**
+ * @file test_stack.cc
+ * @brief Test stacking of overlapping windows over a grid updated by a timer.
+ * Lines of the grid covered by the windows above it are not drawn.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define GRID_ROWS 18
+
+Window* grid_win;
+Window* bar_win;
+Window* box_win;
+
+unsigned long ticks = 0;
+
+void* tick_cb(timer_cb_data_t cb_data)
+{
+  ++ticks;
+  for (int row = 0; row < GRID_ROWS; row++) {
+    char line[80];
+    snprintf(line, sizeof(line), "row %02d tick %-8lu %s", row, ticks,
+        ((ticks + row) % 2) ? "||||||||||||||||||||||||||||||||||||||||||||||" :
+        "----------------------------------------------");
+    grid_win->print(row, 0, line);
+  }
+  return 0;
+}
+
+void toggle(Window* win)
+{
+  if (win->is_visible()) {
+    win->hide();
+  } else {
+    win->show();
+  }
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  switch (ev.key) {
+    case KEY_F(1):
+      toggle(bar_win);
+      break;
+    case KEY_F(2):
+      toggle(box_win);
+      break;
+    case KEY_F(3):
+      grid_win->raise();
+      break;
+    case KEY_F(5):
+      grid_win->lower();
+      break;
+    case KEY_F(4):
+      Screen::exit_screen();
+      break;
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows, later ones are stacked over earlier ones */
+  grid_win = Window::create_window(GRID_ROWS + 2, 78, 0, 0, true, false);
+
+  bar_win = Window::create_window(3, 78, 4, 0, true, false);
+  bar_win->print(0, 0, "F1 bar, F2 box, F3 raise grid, F5 lower grid, F4 exit");
+
+  box_win = Window::create_window(8, 36, 11, 20, true, false);
+  box_win->print(0, 0, "A box over the grid");
+
+  Window* textfield_win = Window::create_window(3, 78, GRID_ROWS + 2, 0, true,
+      true);
+  textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+  scr.set_focus(textfield_win);
+  scr.add_timer(100, &tick_cb, NULL, true);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(textfield_win);
+  Window::destroy_win(box_win);
+  Window::destroy_win(bar_win);
+  Window::destroy_win(grid_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file test_style.cc
+ * @brief Test styled text, backgrounds and borders, and a heatmap recolored
+ * with more color combinations than the terminal has color pairs.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define MAP_ROWS 12
+#define MAP_COLS 48
+#define NUM_STYLES 400
+
+Window* map_win;
+style_id_t heat[NUM_STYLES];
+int frame = 0;
+
+void* tick_cb(timer_cb_data_t cb_data)
+{
+  ++frame;
+  for (int y = 0; y < MAP_ROWS; y++) {
+    for (int x = 0; x < MAP_COLS; x++) {
+      int v = (x * 3 + y * 5 + frame) % NUM_STYLES;
+      map_win->print(y, x, (v % 10 == 0) ? "*" : " ", heat[v]);
+    }
+  }
+  return 0;
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+  scr.enable_color();
+
+  int colors = std::max(COLORS, 8);
+  for (int i = 0; i < NUM_STYLES; i++) {
+    short bg = (colors > 16) ? 16 + (i * 7) % std::min(colors - 16, 216) :
+      i % colors;
+    heat[i] = scr.add_style(style_t(i % 8, bg));
+  }
+
+  style_id_t title = scr.add_style(style_t(COLOR_YELLOW, -1, A_BOLD));
+  style_id_t note = scr.add_style(style_t(-1, -1, A_UNDERLINE));
+  style_id_t panel = scr.add_style(style_t(COLOR_WHITE, COLOR_BLUE));
+  style_id_t frame_style = scr.add_style(style_t(COLOR_CYAN, -1));
+
+  /* create windows */
+  Window* my_win = Window::create_window(22, 60, 1, 1, true, false);
+  my_win->set_border_style(frame_style);
+
+  Window* banner_win = Window::create_window(my_win, 3, 50, 1, 5, true, false);
+  banner_win->print(0, 0, "Heatmap", title);
+  banner_win->print(0, 8, "recolored every 50 ms, F4 to exit", note);
+
+  map_win = Window::create_window(my_win, MAP_ROWS + 2, MAP_COLS + 2, 4, 5,
+      true, false);
+
+  Window* textfield_win = Window::create_window(my_win, 3, 50, 18, 5, true, true);
+  textfield_win->set_background(panel);
+  textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+  scr.add_timer(50, &tick_cb, NULL, true);
+
+  scr.set_focus(textfield_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(textfield_win);
+  Window::destroy_win(map_win);
+  Window::destroy_win(banner_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file test_threads.cc
+ * @brief Test screens on several terminals, each on a render thread of its
+ * own. Run with the device of each terminal, e.g.
+ * test_threads /dev/pts/1 /dev/pts/2 while the shells of those terminals are
+ * kept from reading input, e.g. with sleep.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+struct term {
+  FILE* fp;
+  Screen* scr;
+  Window* my_win;
+  Window* ticks_win;
+  Window* textfield_win;
+  int ticks;
+};
+
+void* tick_cb(timer_cb_data_t cb_data)
+{
+  struct term* t = (struct term*)cb_data;
+  t->ticks_win->print(0, 0, "ticks: " + std::to_string(++t->ticks));
+  return 0;
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    /* Only the terminal where F4 was pressed exits */
+    Screen::exit_screen();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s TTY...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<struct term> terms(argc - 1);
+  int count = 0;
+
+  /* initialize a screen on each terminal */
+  for (int i = 1; i < argc; i++) {
+    struct term& t = terms[count];
+    t.fp = fopen(argv[i], "r+");
+    if (t.fp == NULL) {
+      continue;
+    }
+    t.scr = Screen::create_screen(NULL, t.fp, t.fp);
+    if (t.scr == NULL) {
+      fclose(t.fp);
+      continue;
+    }
+    t.scr->set_cursor(1);
+
+    t.my_win = Window::create_window(t.scr, 14, 60, 1, 1, true, false);
+
+    Window* banner_win = Window::create_window(t.my_win, 3, 50, 1, 5, true,
+        false);
+    banner_win->print(0, 0, std::string("Terminal ") + argv[i] +
+        ", F4 to exit");
+
+    t.ticks = 0;
+    t.ticks_win = Window::create_window(t.my_win, 3, 50, 4, 5, true, false);
+    t.scr->add_timer(20, &tick_cb, &t, true);
+
+    t.textfield_win = Window::create_window(t.my_win, 5, 50, 7, 5, true, true);
+    t.textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+    t.scr->set_focus(t.textfield_win);
+
+    ++count;
+  }
+
+  /* a render thread per screen */
+  for (int i = 0; i < count; i++) {
+    terms[i].scr->start();
+  }
+
+  for (int i = 0; i < count; i++) {
+    terms[i].scr->join();
+  }
+
+  /* deinitialize */
+  for (int i = 0; i < count; i++) {
+    Screen::destroy_screen(terms[i].scr);
+    fclose(terms[i].fp);
+  }
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file test_timer.cc
+ * @brief Test one-shot and periodic timers refreshing windows.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+struct pane {
+  Window* win;
+  unsigned long ms;
+  int ticks;
+  timer_id_t id;
+};
+
+struct pane panes[3];
+
+void* tick_cb(timer_cb_data_t cb_data)
+{
+  struct pane* p = (struct pane*)cb_data;
+  p->win->print(0, 0, "every " + std::to_string(p->ms) + " ms: " +
+      std::to_string(++p->ticks));
+  return 0;
+}
+
+void* stop_cb(timer_cb_data_t cb_data)
+{
+  Window* banner_win = (Window*)cb_data;
+  Screen::get_instance().cancel_timer(panes[0].id);
+  banner_win->print(0, 0, "Fastest pane stopped, F4 to exit");
+  return 0;
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  Window* my_win = Window::create_window(20, 60, 1, 1, true, false);
+
+  Window* banner_win = Window::create_window(my_win, 3, 50, 1, 5, true, false);
+  banner_win->print(0, 0, "Fastest pane stops in 3 s, F4 to exit");
+
+  unsigned long periods[3] = { 50, 250, 1000 };
+  for (int i = 0; i < 3; i++) {
+    panes[i].win = Window::create_window(my_win, 3, 50, 4 + 3 * i, 5, true, false);
+    panes[i].ms = periods[i];
+    panes[i].ticks = 0;
+    panes[i].id = scr.add_timer(periods[i], &tick_cb, &panes[i], true);
+  }
+
+  scr.add_timer(3000, &stop_cb, banner_win);
+
+  Window* textfield_win = Window::create_window(my_win, 5, 50, 13, 5, true, true);
+  textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+  scr.set_focus(textfield_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(textfield_win);
+  for (int i = 2; i >= 0; i--) {
+    Window::destroy_win(panes[i].win);
+  }
+  Window::destroy_win(banner_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file test_undo.cc
+ * @brief Test undo and redo of edits in a textfield, with its text mirrored
+ * from the field buffer in another window.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+Window* edit_win;
+Window* mirror_win;
+Window* status_win;
+
+void mirror()
+{
+  text_view_t text = edit_win->text();
+  for (int row = 0; row < text.size(); row++) {
+    std::string line = text[row].to_string();
+    line.resize(60, ' ');
+    mirror_win->print(row, 0, line);
+  }
+}
+
+void print_status(const char* last)
+{
+  status_win->print(0, 0, std::string(last) +
+      " | Ctrl-_ or F1 undo, Ctrl-R or F2 redo, F4 exit      ");
+}
+
+void term_cb(const KeyEvent& ev)
+{
+  print_status((ev.key == 31) ? "Undo" : (ev.key == 18) ? "Redo" : "Edit");
+  mirror();
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  switch (ev.key) {
+    case KEY_F(1):
+      print_status(edit_win->undo() ? "Undo" : "Nothing to undo");
+      break;
+    case KEY_F(2):
+      print_status(edit_win->redo() ? "Redo" : "Nothing to redo");
+      break;
+    case KEY_F(4):
+      Screen::exit_screen();
+      break;
+  }
+  mirror();
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  edit_win = Window::create_window(5, 62, 0, 0, true, true);
+  edit_win->set_undo_limit(16);
+  edit_win->on_term(key_handler_t::bind<&term_cb>());
+  edit_win->on_key(key_handler_t::bind<&key_cb>());
+
+  mirror_win = Window::create_window(3, 60, 6, 1, false, false);
+
+  status_win = Window::create_window(1, 80, 10, 0, false, false);
+  print_status("Type");
+
+  scr.set_focus(edit_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(status_win);
+  Window::destroy_win(mirror_win);
+  Window::destroy_win(edit_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file test_validate.cc
+ * @brief Test an order entry form of textfields with constraints. Keys
+ * breaking them are dropped before they reach the callbacks.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define NUM_FIELDS 4
+
+Window* status_win;
+
+unsigned long accepted = 0;
+
+void print_status()
+{
+  status_win->print(0, 0, "Accepted " + std::to_string(accepted) +
+      " keys, Tab next field, F4 exit   ");
+}
+
+void term_cb(const KeyEvent& ev)
+{
+  ++accepted;
+  print_status();
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  const char* labels[NUM_FIELDS] = {
+    "Symbol, up to 5 of A-Z", "Quantity, up to 6 digits",
+    "Price, 2 decimals", "Settle date, 99/99/9999"
+  };
+
+  field_constraints_t symbol(5);
+  symbol.charset = "A-Z";
+
+  field_constraints_t qty(6);
+  qty.numeric = true;
+
+  field_constraints_t price(10);
+  price.numeric = true;
+  price.decimals = 2;
+
+  field_constraints_t date;
+  date.mask = "99/99/9999";
+
+  const field_constraints_t* constraints[NUM_FIELDS] = {
+    &symbol, &qty, &price, &date
+  };
+
+  /* create windows */
+  Window* label_wins[NUM_FIELDS];
+  Window* fields[NUM_FIELDS];
+  for (int i = 0; i < NUM_FIELDS; i++) {
+    label_wins[i] = Window::create_window(1, 30, 1 + 3 * i, 1, false, false);
+    label_wins[i]->print(0, 0, labels[i]);
+
+    fields[i] = Window::create_window(3, 20, 3 * i, 32, true, true);
+    fields[i]->set_constraints(*constraints[i]);
+    fields[i]->on_term(key_handler_t::bind<&term_cb>());
+    fields[i]->on_key(key_handler_t::bind<&key_cb>());
+  }
+
+  status_win = Window::create_window(1, 60, 3 * NUM_FIELDS + 1, 1, false,
+      false);
+  print_status();
+
+  scr.set_focus(fields[0]);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(status_win);
+  for (int i = NUM_FIELDS - 1; i >= 0; i--) {
+    Window::destroy_win(fields[i]);
+    Window::destroy_win(label_wins[i]);
+  }
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
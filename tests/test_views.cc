@@ -0,0 +1,84 @@
+/**
+ * @file test_views.cc
+ * @brief Test saving the contents of windows as views and flipping between
+ * them.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+#define NUM_VIEWS 3
+#define NUM_PANES 4
+
+Window* banner_win;
+Window* panes[NUM_PANES];
+
+void render_view(int view)
+{
+  banner_win->print(0, 0, "View " + std::to_string(view + 1) +
+      ", F1-F3 to flip, F4 to exit");
+  for (int i = 0; i < NUM_PANES; i++) {
+    for (int row = 0; row < 3; row++) {
+      panes[i]->print(row, 0, "view " + std::to_string(view + 1) +
+          " pane " + std::to_string(i + 1) + " row " +
+          std::to_string(row + 1));
+    }
+  }
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  Screen& scr = Screen::get_instance();
+
+  if ((ev.key >= KEY_F(1)) && (ev.key < KEY_F(1 + NUM_VIEWS))) {
+    scr.restore_view(ev.key - KEY_F(1));
+  } else if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  Window* my_win = Window::create_window(22, 70, 1, 1, true, false);
+
+  banner_win = Window::create_window(my_win, 3, 60, 1, 5, true, false);
+
+  for (int i = 0; i < NUM_PANES; i++) {
+    panes[i] = Window::create_window(my_win, 5, 30, 4 + 5 * (i / 2),
+        5 + 30 * (i % 2), true, false);
+  }
+
+  Window* textfield_win = Window::create_window(my_win, 3, 60, 14, 5, true, true);
+  textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+  /* render each view once */
+  for (int view = 0; view < NUM_VIEWS; view++) {
+    render_view(view);
+    scr.save_view(view);
+  }
+  scr.restore_view(0);
+
+  scr.set_focus(textfield_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  Window::destroy_win(textfield_win);
+  for (int i = NUM_PANES - 1; i >= 0; i--) {
+    Window::destroy_win(panes[i]);
+  }
+  Window::destroy_win(banner_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
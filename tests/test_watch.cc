@@ -0,0 +1,95 @@
+/**
+ * @file test_watch.cc
+ * @brief Test watching the output of a child process in the event loop.
+ */
+
+#include <ncui.h>
+
+using namespace ncui;
+
+struct feed {
+  Window* win;
+  FILE* pipe;
+  int lines;
+};
+
+void* feed_cb(int fd, int events, fd_cb_data_t cb_data)
+{
+  struct feed* f = (struct feed*)cb_data;
+  char buf[128];
+
+  if (events & FD_EV_READ) {
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    if (len > 0) {
+      buf[len] = '\0';
+      char* nl = strchr(buf, '\n');
+      if (nl != NULL) {
+        *nl = '\0';
+      }
+      f->win->print(0, 0, std::to_string(++f->lines) + ": " + buf);
+      return 0;
+    }
+  }
+
+  /* The child exited */
+  Screen::get_instance().unwatch_fd(fd);
+  pclose(f->pipe);
+  f->pipe = NULL;
+  std::string msg = "Feed closed";
+  msg.resize(48, ' ');
+  f->win->print(0, 0, msg);
+  return 0;
+}
+
+void key_cb(const KeyEvent& ev)
+{
+  if (ev.key == KEY_F(4)) {
+    Screen::exit_screen();
+  }
+}
+
+int main()
+{
+  /* initialize */
+  Screen &scr = Screen::get_instance();
+
+  /* create windows */
+  Window* my_win = Window::create_window(14, 60, 1, 1, true, false);
+
+  Window* banner_win = Window::create_window(my_win, 3, 50, 1, 5, true, false);
+  banner_win->print(0, 0, "Feed ends after 10 lines, F4 to exit");
+
+  struct feed f;
+  f.win = Window::create_window(my_win, 3, 50, 4, 5, true, false);
+  f.lines = 0;
+  f.pipe = popen("for i in 1 2 3 4 5 6 7 8 9 10; do date; sleep 0.5; done",
+      "r");
+  if (f.pipe != NULL) {
+    scr.watch_fd(fileno(f.pipe), FD_EV_READ, &feed_cb, &f);
+  }
+
+  Window* textfield_win = Window::create_window(my_win, 5, 50, 8, 5, true, true);
+  textfield_win->on_key(key_handler_t::bind<&key_cb>());
+
+  scr.set_focus(textfield_win);
+
+  /* main loop */
+  scr.mainloop();
+
+  /* deinitialize */
+  if (f.pipe != NULL) {
+    scr.unwatch_fd(fileno(f.pipe));
+    pclose(f.pipe);
+  }
+
+  Window::destroy_win(textfield_win);
+  Window::destroy_win(f.win);
+  Window::destroy_win(banner_win);
+  Window::destroy_win(my_win);
+
+  scr.end_screen();
+
+  exit_curses(EXIT_SUCCESS);
+
+  return 0;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file ncui_replay.cc
+ * @brief Replay a recording made with Screen::start_recording through the
+ * rendering of ncurses, without a terminal, and report the bytes written to
+ * the terminal and the time taken.
+ */
+
+#include <ncui_common.h>
+#include <ncui_record.h>
+
+#include <sys/stat.h>
+
+using namespace ncui;
+
+static uint64_t now_us()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void usage(const char* prog)
+{
+  fprintf(stderr, "usage: %s [-t TERM] [-n COUNT] RECORDING\n"
+      "  -t TERM   terminal type to render for, default xterm-256color\n"
+      "  -n COUNT  replay the recording COUNT times, default 1\n", prog);
+}
+
+int main(int argc, char* argv[])
+{
+  const char* type = "xterm-256color";
+  int passes = 1;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "t:n:")) != -1) {
+    switch (opt) {
+      case 't':
+        type = optarg;
+        break;
+      case 'n':
+        passes = std::max(atoi(optarg), 1);
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if (optind != argc - 1) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  FILE* rec_fp = fopen(argv[optind], "rb");
+  if (rec_fp == NULL) {
+    perror(argv[optind]);
+    return EXIT_FAILURE;
+  }
+
+  /* ncurses renders into a file instead of a terminal */
+  FILE* out = tmpfile();
+  FILE* in = fopen("/dev/null", "r");
+  if ((out == NULL) || (in == NULL)) {
+    perror("ncui_replay");
+    return EXIT_FAILURE;
+  }
+
+  SCREEN* term = newterm(type, out, in);
+  if (term == NULL) {
+    fprintf(stderr, "ncui_replay: unknown terminal type %s\n", type);
+    return EXIT_FAILURE;
+  }
+  if (has_colors()) {
+    start_color();
+    use_default_colors();
+  }
+
+  rec_record_t rec;
+  unsigned long frames = 0;
+  unsigned long spans = 0;
+  unsigned long cells = 0;
+  uint64_t duration = 0;
+  uint64_t render_us = 0;
+  uint64_t max_us = 0;
+  bool ok = true;
+  bool malformed = false;
+
+  for (int pass = 0; (pass < passes) && ok; pass++) {
+    rewind(rec_fp);
+    frame_reader_t reader(rec_fp);
+    if (!reader.is_valid()) {
+      ok = false;
+      break;
+    }
+
+    while (reader.next(rec)) {
+      uint64_t start = now_us();
+
+      switch (rec.kind) {
+        case REC_SIZE:
+          resizeterm(rec.lines, rec.cols);
+          erase();
+          break;
+
+        case REC_PAIR:
+          init_pair(rec.pair, rec.fg, rec.bg);
+          break;
+
+        case REC_FRAME:
+          for (auto& span : rec.spans) {
+            mvwaddchnstr(stdscr, span.y, span.x, &rec.cells[span.off],
+                span.len);
+            cells += span.len;
+          }
+          spans += rec.spans.size();
+          wnoutrefresh(stdscr);
+          doupdate();
+          ++frames;
+          duration = rec.time;
+          break;
+      }
+
+      uint64_t elapsed = now_us() - start;
+      render_us += elapsed;
+      max_us = std::max(max_us, elapsed);
+    }
+
+    /* A capture cut short is not a reproduction of what was recorded */
+    if (reader.is_malformed()) {
+      malformed = true;
+      break;
+    }
+  }
+
+  endwin();
+  fflush(out);
+
+  struct stat st;
+  off_t out_bytes = (fstat(fileno(out), &st) == 0) ? st.st_size : 0;
+
+  fseek(rec_fp, 0, SEEK_END);
+  long rec_bytes = ftell(rec_fp);
+
+  delscreen(term);
+  fclose(in);
+  fclose(out);
+  fclose(rec_fp);
+
+  if (!ok) {
+    fprintf(stderr, "ncui_replay: %s is not a recording\n", argv[optind]);
+    return EXIT_FAILURE;
+  }
+  if (malformed) {
+    fprintf(stderr, "ncui_replay: %s is truncated or corrupt after %lu "
+        "frames\n", argv[optind], frames);
+    return EXIT_FAILURE;
+  }
+
+  printf("recording:       %ld bytes, %lu frames over %.3f s\n",
+      rec_bytes, frames / passes, duration / 1000.0);
+  printf("damage:          %lu spans, %lu cells\n", spans, cells);
+  printf("terminal output: %lld bytes\n", (long long)out_bytes);
+  printf("render time:     %.3f ms, %.1f us/frame, max %llu us\n",
+      render_us / 1000.0, (frames > 0) ? (double)render_us / frames : 0.0,
+      (unsigned long long)max_us);
+
+  return EXIT_SUCCESS;
+}